@@ -1,6 +1,7 @@
 
 #define SSD_ALIGN_LEAP_DLL_EXPORTS
 #include "ssd_align_leap_dll.h"
+#include "ssd_kernels.h" /* fused AlignFlow/UpdateKappa kernels shared with ssd_core */
 
 #include <vector>
 #include <random>
@@ -20,10 +21,21 @@ struct SSDHandle {
   std::normal_distribution<double> norm01;
   std::uniform_real_distribution<double> uni01;
 
+  /* step scratch, sized once here so steady-state stepping never allocates */
+  std::vector<double> j;         /* N*N align flow */
+  std::vector<double> logits;    /* size N */
+  std::vector<uint64_t> relax_hist; /* radix-select histogram for relax-top */
+
+  /* fused kernel specialized at compile time, indexed by (eps_noise > 0);
+     chosen once here by CPU dispatch so the N*N loop never branches */
+  SSDAlignKernel<double> align[2];
+
   SSDHandle(int n, const SSDParams& p, uint64_t seed)
   : N(n), current(0), kappa(n*n, 0.0), w(n*n, 0.0),
     E(0.0), F(0.0), T(p.T0), pi(n, 1.0 / std::max(1,n)),
-    prm(p), rng(seed), norm01(0.0, 1.0), uni01(0.0, 1.0) {}
+    prm(p), rng(seed), norm01(0.0, 1.0), uni01(0.0, 1.0),
+    j(n*n, 0.0), logits(n, 0.0), relax_hist(SSD_RELAX_HIST_SIZE, 0),
+    align{ssd_select_align_kernel_t<double>(false), ssd_select_align_kernel_t<double>(true)} {}
 };
 
 /* --- helpers --- */
@@ -123,28 +135,19 @@ extern "C" void ssd_step(SSDHandle* h, double p, double dt, SSDTelemetry* out) {
   int N = h->N;
   auto& prm = h->prm;
 
-  // ----- 1) AlignFlow -----
-  // j = (G0 + g*kappa) * p [+ noise]
-  std::vector<double> j(N*N, 0.0);
-  double J_norm = 0.0;
-  for (int i=0;i<N*N;++i) {
-    double val = (prm.G0 + prm.g * h->kappa[i]) * p;
-    // optional noise
-    if (prm.eps_noise > 0.0) {
-      val += prm.eps_noise * h->norm01(h->rng);
-    }
-    j[i] = val;
-    J_norm += val*val;
-  }
-  J_norm = std::sqrt(J_norm);
-
-  // ----- 2) UpdateKappa -----
-  for (int i=0;i<N*N;++i) {
-    double gain = prm.eta * (p * j[i] - prm.rho * j[i]*j[i]);
-    double decay = prm.lam * (h->kappa[i] - prm.kappa_min);
-    double k = h->kappa[i] + (gain - decay) * dt;
-    h->kappa[i] = (k < prm.kappa_min) ? prm.kappa_min : k;
+  // ----- 1+2) AlignFlow + UpdateKappa (one fused pass) -----
+  // j = (G0 + g*kappa) * p [+ noise]; noise is drawn into j first, in the same order as before.
+  // The stream stays std::mt19937_64 + normal_distribution in call order (ssd_core's
+  // SSDRandom and step body need ssd_core.h, whose C API clashes with this header)
+  std::vector<double>& j = h->j;
+  const bool noisy = prm.eps_noise > 0.0;
+  if (noisy) {
+    for (int i=0;i<N*N;++i) j[i] = prm.eps_noise * h->norm01(h->rng);
   }
+  AlignKernelArgs args{prm.G0, prm.g, p, prm.eta, prm.rho, prm.lam, prm.kappa_min, dt};
+  AlignKernelResult fused = h->align[noisy](args, h->kappa.data(), j.data(), j.data(),
+                                            (size_t)N*N, 0, 0);
+  double J_norm = std::sqrt(fused.J_sq);
 
   // ----- 3) UpdateHeat -----
   double dE = prm.alpha * std::max(std::abs(p) - J_norm, 0.0) - prm.beta_E * h->E;
@@ -152,10 +155,8 @@ extern "C" void ssd_step(SSDHandle* h, double p, double dt, SSDTelemetry* out) {
   if (h->E < 0.0) h->E = 0.0;
 
   // ----- 4) Threshold / JumpRate / Temperature -----
-  // kappa_mean
-  double km = 0.0;
-  for (double x: h->kappa) km += x;
-  km /= (double)(N*N);
+  // kappa_mean (sum of the updated kappa comes out of the fused pass)
+  double km = fused.kappa_sum / (double)(N*N);
 
   double Theta = prm.Theta0 + prm.a1*km - prm.a2*h->F;
   double hrate = prm.h0 * std::exp((h->E - Theta) / std::max(1e-8, prm.gamma));
@@ -172,7 +173,7 @@ extern "C" void ssd_step(SSDHandle* h, double p, double dt, SSDTelemetry* out) {
   if (h->uni01(h->rng) < p_jump) {
     did_jump = true;
     // policy from current row
-    std::vector<double> logits(N, 0.0);
+    std::vector<double>& logits = h->logits;
     for (int k=0;k<N;++k) {
       logits[k] = h->kappa[idx(h->current,k,N)];
       if (k == h->current) logits[k] -= 1.0; // discourage self-loop
@@ -193,17 +194,14 @@ extern "C" void ssd_step(SSDHandle* h, double p, double dt, SSDTelemetry* out) {
 
     // relax top-q% by j
     int M = N*N;
-    int qn = std::max(1, (int)std::round(prm.q_relax * M));
-    // get indices of top qn by absolute j
-    std::vector<int> indices(M);
-    for (int i=0;i<M;++i) indices[i]=i;
-    std::partial_sort(indices.begin(), indices.begin()+qn, indices.end(),
-      [&](int a, int b){ return std::abs(j[a]) > std::abs(j[b]); });
-    for (int ii=0; ii<qn; ++ii) {
-      int pos = indices[ii];
+    int qn = std::min(M, std::max(1, (int)std::round(prm.q_relax * M)));
+    // radix-select the |j| cut shared with ssd_core (no index sort), then relax
+    // everything above it plus the first cut.ties equal keys in index order
+    RelaxCut cut = ssd_relax_threshold(j.data(), (size_t)M, (size_t)qn, h->relax_hist.data());
+    ssd_relax_for_each(j.data(), 0, (size_t)M, cut.key, cut.ties, [&](size_t pos) {
       double k = h->kappa[pos] - prm.eps_relax;
       h->kappa[pos] = (k < prm.kappa_min) ? prm.kappa_min : k;
-    }
+    });
   } else {
     // epsilon-random
     double kappa_mean = km;
@@ -217,15 +215,9 @@ extern "C" void ssd_step(SSDHandle* h, double p, double dt, SSDTelemetry* out) {
         h->kappa[idx(h->current, k, N)] += 0.05;
       }
     }
-    // deterministic action: go to argmax kappa row
+    // deterministic action: go to argmax kappa row (same tie rule as ssd_core)
     int s = h->current;
-    int best = s;
-    double bestv = -1e300;
-    for (int k=0;k<N;++k) {
-      double v = h->kappa[idx(s,k,N)];
-      if (k==s) v -= 1e-6;
-      if (v > bestv){ bestv=v; best=k; }
-    }
+    int best = ssd_argmax_pick(s, N, [&](int k) { return h->kappa[idx(s,k,N)]; });
     h->current = best;
     rewired_to = best;
   }
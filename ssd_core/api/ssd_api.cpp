@@ -1,5 +1,6 @@
 ﻿#include "ssd_api.h"
 #include "../bridge/neuro_ssd_bridge.h"
+#include "../core/neuro_population.h"
 
 // C APIラッパー実装
 
@@ -25,6 +26,40 @@ extern "C" void neurossd_apply_event(NeuroSSDSystem* sys, const char* event_id)
     sys->ApplyEvent(std::string_view(event_id));
 }
 
+extern "C" int32_t neurossd_event_id(const char* name) {
+    if (!name) return -1;
+    return NeuroEvents().Find(name);
+}
+
+extern "C" int32_t neurossd_register_event(const char* name, const NeuroState* delta) {
+    if (!name || !delta) return -1;
+    try {
+        return NeuroEvents().Register(name, *delta);
+    } catch (...) {
+        return -1;
+    }
+}
+
+extern "C" int32_t neurossd_load_event_table(const char* path) {
+    try {
+        return NeuroEvents().LoadFile(path);
+    } catch (...) {
+        return -1;
+    }
+}
+
+extern "C" void neurossd_apply_event_id(NeuroSSDSystem* sys, int32_t event_id) {
+    if (!sys) return;
+    sys->ApplyEvent(event_id);
+}
+
+extern "C" void neurossd_apply_events(NeuroSSDSystem* const* systems, const int32_t* event_ids, int32_t count) {
+    if (!systems || !event_ids) return;
+    for (int32_t k = 0; k < count; ++k) {
+        if (systems[k]) systems[k]->ApplyEvent(event_ids[k]);
+    }
+}
+
 extern "C" void neurossd_get_neuro_state(NeuroSSDSystem* sys, NeuroState* out) {
     if (!sys || !out) return;
     *out = sys->GetNeuroState();
@@ -48,18 +83,87 @@ extern "C" void neurossd_get_neuro_baseline(NeuroSSDSystem* sys, NeuroState* out
 }
 
 // デバッグ・監視用
-extern "C" int32_t neurossd_get_current_node(NeuroSSDSystem* sys) {
+// いずれもステップを進めずに読む（ssd_get_state）
+extern "C" int32_t neurossd_get_ssd_state(NeuroSSDSystem* sys, SSDStateView* out) {
     if (!sys) return -1;
-    
-    SSDTelemetry telem;
-    ssd_step(sys->ssd_handle, 0.0, 0.0, &telem);  // ダミー呼び出し
-    return telem.current;
+    return ssd_get_state(sys->ssd_handle, out);
+}
+
+extern "C" int32_t neurossd_get_current_node(NeuroSSDSystem* sys) {
+    SSDStateView state;
+    return neurossd_get_ssd_state(sys, &state) == 0 ? state.current : -1;
 }
 
 extern "C" double neurossd_get_heat_level(NeuroSSDSystem* sys) {
-    if (!sys) return 0.0;
-    
-    SSDTelemetry telem;
-    ssd_step(sys->ssd_handle, 0.0, 0.0, &telem);  // ダミー呼び出し
-    return telem.E;
-}
\ No newline at end of file
+    SSDStateView state;
+    return neurossd_get_ssd_state(sys, &state) == 0 ? state.E : 0.0;
+}
+
+// 神経集団
+
+static bool valid_agent(NeuroPopulation* pop, int32_t agent) {
+    return pop && agent >= 0 && (size_t)agent < pop->Size();
+}
+
+extern "C" NeuroPopulation* neuropop_create(int32_t count) {
+    if (count <= 0) return nullptr;
+    try {
+        return new NeuroPopulation((size_t)count);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+extern "C" void neuropop_destroy(NeuroPopulation* pop) {
+    delete pop;
+}
+
+extern "C" int32_t neuropop_size(NeuroPopulation* pop) {
+    return pop ? (int32_t)pop->Size() : 0;
+}
+
+extern "C" void neuropop_tick_all(NeuroPopulation* pop, float dt_sec) {
+    if (!pop) return;
+    pop->TickAll(dt_sec);
+}
+
+extern "C" void neuropop_apply_event(NeuroPopulation* pop, int32_t agent, const char* event_id) {
+    if (!valid_agent(pop, agent) || !event_id) return;
+    pop->ApplyEvent((size_t)agent, std::string_view(event_id));
+}
+
+extern "C" void neuropop_apply_event_id(NeuroPopulation* pop, int32_t agent, int32_t event_id) {
+    if (!valid_agent(pop, agent)) return;
+    pop->ApplyEvent((size_t)agent, event_id);
+}
+
+extern "C" void neuropop_apply_events(NeuroPopulation* pop, const int32_t* agents, const int32_t* event_ids,
+                                      int32_t count) {
+    if (!pop || !agents || !event_ids || count <= 0) return;
+    pop->ApplyEvents(agents, event_ids, (size_t)count);
+}
+
+extern "C" void neuropop_get_state(NeuroPopulation* pop, int32_t agent, NeuroState* out) {
+    if (!valid_agent(pop, agent) || !out) return;
+    *out = pop->Get((size_t)agent);
+}
+
+extern "C" void neuropop_set_state(NeuroPopulation* pop, int32_t agent, const NeuroState* state) {
+    if (!valid_agent(pop, agent) || !state) return;
+    pop->Set((size_t)agent, *state);
+}
+
+extern "C" void neuropop_get_baseline(NeuroPopulation* pop, int32_t agent, NeuroState* out) {
+    if (!valid_agent(pop, agent) || !out) return;
+    *out = pop->GetBaseline((size_t)agent);
+}
+
+extern "C" void neuropop_set_baseline(NeuroPopulation* pop, int32_t agent, const NeuroState* baseline) {
+    if (!valid_agent(pop, agent) || !baseline) return;
+    pop->SetBaseline((size_t)agent, *baseline);
+}
+
+extern "C" const float* neuropop_channel(NeuroPopulation* pop, int32_t channel) {
+    if (!pop || channel < 0 || channel >= NEURO_CHANNELS) return nullptr;
+    return pop->Channel(channel);
+}
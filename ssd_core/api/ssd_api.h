@@ -18,6 +18,7 @@ extern "C" {
 
 // 前方宣言
 typedef struct NeuroSSDSystem NeuroSSDSystem;
+typedef struct NeuroPopulation NeuroPopulation;
 
 // === 基本ライフサイクル ===
 UNIFIED_API NeuroSSDSystem* neurossd_create(int32_t N, uint64_t seed);
@@ -29,6 +30,19 @@ UNIFIED_API void neurossd_tick(NeuroSSDSystem* sys, double meaning_pressure, flo
 // === イベント処理 ===
 UNIFIED_API void neurossd_apply_event(NeuroSSDSystem* sys, const char* event_id);
 
+// イベント名は起動時に整数 id へ変換しておき、以後は id で適用する（文字列比較なし）。
+// 組み込みイベント（praise 等）は最初から登録済み。登録・読み込みはイベントの適用と並行させない
+// 名前の id（未登録は -1）
+UNIFIED_API int32_t neurossd_event_id(const char* name);
+// 登録して id を返す（既存の名前は変化量を上書き、NULL・空の名前は -1）
+UNIFIED_API int32_t neurossd_register_event(const char* name, const NeuroState* delta);
+// 表ファイル（1行1件「名前 DA S5 NE AD END OXT CORT」、# 以降は注釈）を登録し件数を返す。
+// 開けない・書式の誤りは -1（何も登録しない）
+UNIFIED_API int32_t neurossd_load_event_table(const char* path);
+UNIFIED_API void neurossd_apply_event_id(NeuroSSDSystem* sys, int32_t event_id);
+// systems[k] に event_ids[k] を k の順に適用する（NULL・範囲外の id は飛ばす）
+UNIFIED_API void neurossd_apply_events(NeuroSSDSystem* const* systems, const int32_t* event_ids, int32_t count);
+
 // === 状態取得 ===
 UNIFIED_API void neurossd_get_neuro_state(NeuroSSDSystem* sys, NeuroState* out);
 UNIFIED_API void neurossd_get_ssd_params(NeuroSSDSystem* sys, SSDParams* out);
@@ -37,9 +51,28 @@ UNIFIED_API void neurossd_get_ssd_params(NeuroSSDSystem* sys, SSDParams* out);
 UNIFIED_API void neurossd_set_neuro_baseline(NeuroSSDSystem* sys, const NeuroState* baseline);
 UNIFIED_API void neurossd_get_neuro_baseline(NeuroSSDSystem* sys, NeuroState* out);
 
-// === デバッグ・監視 ===
-UNIFIED_API int32_t neurossd_get_current_node(NeuroSSDSystem* sys);
-UNIFIED_API double neurossd_get_heat_level(NeuroSSDSystem* sys);
+// === デバッグ・監視（ステップを進めず O(1) で読む） ===
+UNIFIED_API int32_t neurossd_get_ssd_state(NeuroSSDSystem* sys, SSDStateView* out);  // ssd_get_state
+UNIFIED_API int32_t neurossd_get_current_node(NeuroSSDSystem* sys);  // 不正な引数は -1
+UNIFIED_API double neurossd_get_heat_level(NeuroSSDSystem* sys);     // 熱 E（不正な引数は 0）
+
+// === 神経集団（多数のエージェントの神経状態を成分ごとの配列で一括更新） ===
+// agent は 0..count-1、範囲外は無視（取得系は out を書かない）
+UNIFIED_API NeuroPopulation* neuropop_create(int32_t count);
+UNIFIED_API void neuropop_destroy(NeuroPopulation* pop);
+UNIFIED_API int32_t neuropop_size(NeuroPopulation* pop);
+UNIFIED_API void neuropop_tick_all(NeuroPopulation* pop, float dt_sec);
+UNIFIED_API void neuropop_apply_event(NeuroPopulation* pop, int32_t agent, const char* event_id);
+UNIFIED_API void neuropop_apply_event_id(NeuroPopulation* pop, int32_t agent, int32_t event_id);
+// (agents[k], event_ids[k]) の組を k の順に一括適用する（範囲外の agent・id は飛ばす）
+UNIFIED_API void neuropop_apply_events(NeuroPopulation* pop, const int32_t* agents, const int32_t* event_ids, int32_t count);
+UNIFIED_API void neuropop_get_state(NeuroPopulation* pop, int32_t agent, NeuroState* out);
+UNIFIED_API void neuropop_set_state(NeuroPopulation* pop, int32_t agent, const NeuroState* state);
+UNIFIED_API void neuropop_get_baseline(NeuroPopulation* pop, int32_t agent, NeuroState* out);
+UNIFIED_API void neuropop_set_baseline(NeuroPopulation* pop, int32_t agent, const NeuroState* baseline);
+// 成分 channel（0=DA .. 6=CORT、NeuroState のメンバ順）の現在値の配列（長さ count、コピーなし）。
+// 次の neuropop_tick_all / 書き込みまで有効。範囲外の channel は NULL
+UNIFIED_API const float* neuropop_channel(NeuroPopulation* pop, int32_t channel);
 
 #ifdef __cplusplus
 }
@@ -1,5 +1,6 @@
 ﻿#include "neuro_ssd_bridge.h"
 #include <algorithm>
+#include <cmath>
 
 static inline double dev(float u01) { return 2.0 * double(u01) - 1.0; }
 static inline double clip01(double v) { return v < 0 ? 0 : (v > 1 ? 1 : v); }
@@ -27,24 +28,41 @@ void MapNeuroToSSD(const NeuroState& n, SSDParams& prm) {
   prm.sigma = clip01(prm.sigma + s1*DA - s2*S5);
 }
 
+// 直近の写像時から神経状態が eps を超えて動いたか
+static bool neuro_moved(const NeuroState& a, const NeuroState& b, float eps) {
+  return std::abs(a.DA - b.DA) > eps || std::abs(a.S5 - b.S5) > eps ||
+         std::abs(a.NE - b.NE) > eps || std::abs(a.AD - b.AD) > eps ||
+         std::abs(a.END - b.END) > eps || std::abs(a.OXT - b.OXT) > eps ||
+         std::abs(a.CORT - b.CORT) > eps;
+}
+
 NeuroSSDSystem::NeuroSSDSystem(int32_t N, uint64_t seed) {
-  SSDParams default_params{}; // デフォルト初期化
-  ssd_handle = ssd_create(N, &default_params, seed ? seed : 123456789ULL);
+  ssd_handle = ssd_create(N, &base_params, seed ? seed : 123456789ULL);
 }
 
 NeuroSSDSystem::~NeuroSSDSystem() {
   if (ssd_handle) ssd_destroy(ssd_handle);
 }
 
+void NeuroSSDSystem::SetBaseParams(const SSDParams& params) {
+  base_params = params;
+  remap_pending = true;
+}
+
+void NeuroSSDSystem::Remap() {
+  SSDParams modulated = base_params;
+  MapNeuroToSSD(neuro.Get(), modulated);
+  ssd_set_params(ssd_handle, &modulated);
+  mapped_state = neuro.Get();
+  remap_pending = false;
+}
+
 void NeuroSSDSystem::Tick(double meaning_pressure, float dt_sec, SSDTelemetry* telemetry) {
   // 1. 神経系更新
   neuro.Tick(dt_sec);
   
-  // 2. 神経→SSD写像
-  SSDParams current_params;
-  ssd_get_params(ssd_handle, &current_params);
-  MapNeuroToSSD(neuro.Get(), current_params);
-  ssd_set_params(ssd_handle, &current_params);
+  // 2. 神経→SSD写像（状態が十分動いたときだけ、基準値から作り直す）
+  if (remap_pending || neuro_moved(neuro.Get(), mapped_state, kRemapEpsilon)) Remap();
   
   // 3. SSD更新
   ssd_step(ssd_handle, meaning_pressure, double(dt_sec), telemetry);
@@ -52,4 +70,8 @@ void NeuroSSDSystem::Tick(double meaning_pressure, float dt_sec, SSDTelemetry* t
 
 void NeuroSSDSystem::ApplyEvent(std::string_view event_id) {
   neuro.ApplyEvent(event_id);
+}
+
+void NeuroSSDSystem::ApplyEvent(int32_t event_id) {
+  neuro.ApplyEvent(event_id);
 }
\ No newline at end of file
@@ -2,20 +2,40 @@
 #include "../core/neuro_core.h"
 #include "../core/ssd_core.h"
 
-// 神経状態からSSDパラメータへの写像
+// 神経状態からSSDパラメータへの写像（ssd_params に変調を足す。基準値のコピーに対して呼ぶ）
 void MapNeuroToSSD(const NeuroState& neuro_state, SSDParams& ssd_params);
 
 // 統合システム
+//
+// SSDパラメータは変調前の基準値 base_params を保持し、写像は常に基準値に対して行う
+// （変調済みの値に重ねて足さないので、tick を重ねても値がずれていかない）。
+// 写像し直すのは神経状態が直近の写像時から kRemapEpsilon を超えて動いたときだけで、
+// 通常の tick はパラメータに触れずにそのままステップする
 struct NeuroSSDSystem {
   NeuroCore neuro;
   SSDHandle* ssd_handle;
-  
+
+  // 写像し直す神経状態の変化幅（各成分の絶対差の最大値）
+  static constexpr float kRemapEpsilon = 1e-3f;
+
   NeuroSSDSystem(int32_t N, uint64_t seed = 0);
   ~NeuroSSDSystem();
   
   void Tick(double meaning_pressure, float dt_sec, SSDTelemetry* telemetry = nullptr);
   void ApplyEvent(std::string_view event_id);
+  void ApplyEvent(int32_t event_id);  // NeuroEvents() の id
   
   const NeuroState& GetNeuroState() const { return neuro.Get(); }
+  // 変調後（ステップが使っている）のパラメータ
   void GetSSDParams(SSDParams* out) const { ssd_get_params(ssd_handle, out); }
+  // 基準値を差し替える（次の tick で写像し直す）
+  void SetBaseParams(const SSDParams& params);
+  const SSDParams& GetBaseParams() const { return base_params; }
+
+private:
+  void Remap();
+
+  SSDParams base_params{};   // 変調前のパラメータ（写像で書き換えない）
+  NeuroState mapped_state{}; // 直近の写像に使った神経状態
+  bool remap_pending = true;
 };
\ No newline at end of file
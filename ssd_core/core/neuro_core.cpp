@@ -1,5 +1,8 @@
 ﻿#include "neuro_core.h"
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 
 static inline float clamp01(float v) {
     return v < 0 ? 0 : (v > 1 ? 1 : v);
@@ -21,7 +24,7 @@ void NeuroCore::Tick(float dt) {
     step(x.CORT, baseline.CORT, tau_CORT);
 }
 
-// 代表的イベント定義
+// 代表的イベント定義（NeuroEventRegistry の組み込み分）
 struct NeuroEvent {
     const char* id;
     NeuroState delta;
@@ -35,21 +38,98 @@ static const NeuroEvent kEvents[] = {
     {"comfort",          {+0.02f, +0.05f, -0.05f,   0.0f, +0.05f, +0.08f, -0.05f}},
 };
 
+NeuroEventRegistry::NeuroEventRegistry() {
+    for (const auto& event : kEvents) Register(event.id, event.delta);
+}
+
+int32_t NeuroEventRegistry::Register(std::string_view name, const NeuroState& delta) {
+    if (name.empty()) return -1;
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        deltas[it->second] = delta;
+        return it->second;
+    }
+    int32_t id = (int32_t)deltas.size();
+    deltas.push_back(delta);
+    names.emplace_back(name);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+int32_t NeuroEventRegistry::Find(std::string_view name) const {
+    auto it = ids.find(name);
+    return it != ids.end() ? it->second : -1;
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+int32_t NeuroEventRegistry::LoadTable(std::string_view text) {
+    // 全行を解釈してから登録する（途中で誤りがあれば何も変えない）
+    std::vector<std::pair<std::string, NeuroState>> rows;
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text = eol == std::string_view::npos ? std::string_view() : text.substr(eol + 1);
+        line = line.substr(0, line.find('#'));
+
+        std::vector<std::string> tok;
+        for (size_t i = 0; i < line.size();) {
+            while (i < line.size() && is_space(line[i])) ++i;
+            size_t start = i;
+            while (i < line.size() && !is_space(line[i])) ++i;
+            if (i > start) tok.emplace_back(line.substr(start, i - start));
+        }
+        if (tok.empty()) continue;
+        if (tok.size() != 8) return -1;
+
+        float v[7];
+        for (int c = 0; c < 7; ++c) {
+            char* end = nullptr;
+            v[c] = std::strtof(tok[c + 1].c_str(), &end);
+            // strtof は nan / inf も受け付けるので有限値以外も書式の誤りとする
+            if (*end != '\0' || !std::isfinite(v[c])) return -1;
+        }
+        rows.emplace_back(tok[0], NeuroState{v[0], v[1], v[2], v[3], v[4], v[5], v[6]});
+    }
+    for (const auto& r : rows) Register(r.first, r.second);
+    return (int32_t)rows.size();
+}
+
+int32_t NeuroEventRegistry::LoadFile(const char* path) {
+    FILE* f = path ? std::fopen(path, "rb") : nullptr;
+    if (!f) return -1;
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    bool failed = std::ferror(f) != 0;
+    std::fclose(f);
+    return failed ? -1 : LoadTable(text);
+}
+
+NeuroEventRegistry& NeuroEvents() {
+    static NeuroEventRegistry registry;
+    return registry;
+}
+
 void NeuroCore::ApplyEvent(std::string_view id) {
+    ApplyEvent(NeuroEvents().Find(id));
+}
+
+void NeuroCore::ApplyEvent(int32_t id) {
     auto add_clamp = [](float& v, float delta) {
         v = clamp01(v + delta);
         };
 
-    for (const auto& event : kEvents) {
-        if (id == event.id) {
-            add_clamp(x.DA, event.delta.DA);
-            add_clamp(x.S5, event.delta.S5);
-            add_clamp(x.NE, event.delta.NE);
-            add_clamp(x.AD, event.delta.AD);
-            add_clamp(x.END, event.delta.END);
-            add_clamp(x.OXT, event.delta.OXT);
-            add_clamp(x.CORT, event.delta.CORT);
-            return;
-        }
-    }
+    const NeuroState* delta = NeuroEvents().Delta(id);
+    if (!delta) return;
+    add_clamp(x.DA, delta->DA);
+    add_clamp(x.S5, delta->S5);
+    add_clamp(x.NE, delta->NE);
+    add_clamp(x.AD, delta->AD);
+    add_clamp(x.END, delta->END);
+    add_clamp(x.OXT, delta->OXT);
+    add_clamp(x.CORT, delta->CORT);
 }
\ No newline at end of file
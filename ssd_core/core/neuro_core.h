@@ -1,5 +1,12 @@
 ﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 struct NeuroState { 
   float DA = 0.5f;   // ドーパミン
@@ -11,6 +18,41 @@ struct NeuroState {
   float CORT = 0.5f; // コルチゾル
 };
 
+// イベント登録表: 名前を整数 id（登録順に 0, 1, ...）に割り当て、id から変化量を O(1) で引く。
+// 組み込みの代表的イベントは作成時に登録済み。表の読み込み・登録は起動時に済ませ、
+// イベントの適用と並行させない
+struct NeuroEventRegistry {
+  NeuroEventRegistry();
+  // ids は names の文字列を指すので複製しない
+  NeuroEventRegistry(const NeuroEventRegistry&) = delete;
+  NeuroEventRegistry& operator=(const NeuroEventRegistry&) = delete;
+
+  // 既存の名前なら変化量を上書きして同じ id を返す（空の名前は -1）
+  int32_t Register(std::string_view name, const NeuroState& delta);
+  // 未登録は -1（文字列の複製・確保なしでハッシュを引くが、毎フレームの経路では
+  // 一度引いた id を ApplyEvent(int32_t) に渡す）
+  int32_t Find(std::string_view name) const;
+  // 範囲外の id は nullptr
+  const NeuroState* Delta(int32_t id) const {
+    return id >= 0 && (size_t)id < deltas.size() ? &deltas[id] : nullptr;
+  }
+  size_t Size() const { return deltas.size(); }
+
+  // 1行1件「名前 DA S5 NE AD END OXT CORT」（空白区切り、# 以降は注釈）の表を登録し、
+  // 件数を返す。書式の誤りがあれば何も登録せず -1
+  int32_t LoadTable(std::string_view text);
+  // ファイルから LoadTable（開けなければ -1）
+  int32_t LoadFile(const char* path);
+
+private:
+  std::vector<NeuroState> deltas;  /* id → 変化量 */
+  std::deque<std::string> names;   /* id → 名前（追加しても既存の要素は動かない） */
+  std::unordered_map<std::string_view, int32_t> ids;  /* names の要素を指す */
+};
+
+// プロセス共通の登録表（NeuroCore / NeuroPopulation の ApplyEvent が引く）
+NeuroEventRegistry& NeuroEvents();
+
 struct NeuroCore {
   NeuroState baseline{};
   NeuroState x{};
@@ -25,7 +67,8 @@ struct NeuroCore {
   float tau_CORT = 120.0f;
 
   void Tick(float dt_sec);
-  void ApplyEvent(std::string_view event_id);
+  void ApplyEvent(std::string_view event_id);  // 名前を NeuroEvents() で引く（未登録は無視）
+  void ApplyEvent(int32_t event_id);           // 登録表の id（範囲外は無視）
   const NeuroState& Get() const { return x; }
   
   // オキシトシンブースト計算
@@ -0,0 +1,138 @@
+﻿#include "neuro_population.h"
+
+#include <new>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define NEURO_POP_X86 1
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+    #define NEURO_TARGET_AVX
+  #else
+    #define NEURO_TARGET_AVX __attribute__((target("avx")))
+  #endif
+#else
+  #define NEURO_POP_X86 0
+#endif
+
+static constexpr size_t kAlign = 32;
+
+static float NeuroState::* const kMembers[NEURO_CHANNELS] = {
+    &NeuroState::DA, &NeuroState::S5, &NeuroState::NE, &NeuroState::AD,
+    &NeuroState::END, &NeuroState::OXT, &NeuroState::CORT,
+};
+
+void NeuroPopulation::AlignedDelete::operator()(float* p) const {
+    ::operator delete[](p, std::align_val_t(kAlign));
+}
+
+NeuroPopulation::NeuroPopulation(size_t n)
+    : count(n), stride((n + kLanes - 1) / kLanes * kLanes) {
+    size_t total = 2 * NEURO_CHANNELS * stride;
+    data.reset(static_cast<float*>(::operator new[](total * sizeof(float), std::align_val_t(kAlign))));
+    NeuroState init{};
+    for (int c = 0; c < NEURO_CHANNELS; ++c) {
+        for (size_t i = 0; i < stride; ++i) {
+            float v = i < n ? init.*kMembers[c] : 0.0f;
+            Channel(c)[i] = v;
+            BaselineChannel(c)[i] = v;
+        }
+    }
+}
+
+static inline float clamp01(float v) {
+    return v < 0 ? 0 : (v > 1 ? 1 : v);
+}
+
+// NeuroCore::Tick と同じ式: v += (b - v) * (dt / tau) の後に [0, 1] へ
+static void relax_scalar(float* v, const float* b, size_t n, float k) {
+    for (size_t i = 0; i < n; ++i) v[i] = clamp01(v[i] + (b[i] - v[i]) * k);
+}
+
+#if NEURO_POP_X86
+// FMA は使わない（スカラー版・NeuroCore とビット一致させる）。
+// max / min は引数の順で clamp01 と同じ結果（-0.0 と NaN はそのまま）になる
+NEURO_TARGET_AVX
+static void relax_avx(float* v, const float* b, size_t n, float k) {
+    const __m256 kk = _mm256_set1_ps(k);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    for (size_t i = 0; i < n; i += 8) {
+        __m256 x = _mm256_load_ps(v + i);
+        __m256 d = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(b + i), x), kk);
+        x = _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_add_ps(x, d)));
+        _mm256_store_ps(v + i, x);
+    }
+}
+
+static bool cpu_has_avx() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx");
+#endif
+}
+#endif
+
+void NeuroPopulation::TickAll(float dt) {
+    using RelaxFn = void (*)(float*, const float*, size_t, float);
+#if NEURO_POP_X86
+    static const RelaxFn relax = cpu_has_avx() ? relax_avx : relax_scalar;
+#else
+    static const RelaxFn relax = relax_scalar;
+#endif
+    for (int c = 0; c < NEURO_CHANNELS; ++c) {
+        if (tau[c] <= 1e-3f) continue;
+        relax(Channel(c), BaselineChannel(c), stride, dt / tau[c]);
+    }
+}
+
+void NeuroPopulation::ApplyEvent(size_t agent, std::string_view event_id) {
+    ApplyEvent(agent, NeuroEvents().Find(event_id));
+}
+
+void NeuroPopulation::ApplyEvent(size_t agent, int32_t event_id) {
+    const NeuroState* delta = NeuroEvents().Delta(event_id);
+    if (!delta || agent >= count) return;
+    for (int c = 0; c < NEURO_CHANNELS; ++c) {
+        float& v = Channel(c)[agent];
+        v = clamp01(v + delta->*kMembers[c]);
+    }
+}
+
+void NeuroPopulation::ApplyEvents(const int32_t* agents, const int32_t* event_ids, size_t n) {
+    const NeuroEventRegistry& events = NeuroEvents();
+    float* ch[NEURO_CHANNELS];
+    for (int c = 0; c < NEURO_CHANNELS; ++c) ch[c] = Channel(c);
+    for (size_t k = 0; k < n; ++k) {
+        const NeuroState* delta = events.Delta(event_ids[k]);
+        if (!delta || agents[k] < 0 || (size_t)agents[k] >= count) continue;
+        size_t a = (size_t)agents[k];
+        for (int c = 0; c < NEURO_CHANNELS; ++c) ch[c][a] = clamp01(ch[c][a] + delta->*kMembers[c]);
+    }
+}
+
+NeuroState NeuroPopulation::Get(size_t agent) const {
+    NeuroState s{};
+    for (int c = 0; c < NEURO_CHANNELS; ++c) s.*kMembers[c] = Channel(c)[agent];
+    return s;
+}
+
+void NeuroPopulation::Set(size_t agent, const NeuroState& state) {
+    for (int c = 0; c < NEURO_CHANNELS; ++c) Channel(c)[agent] = state.*kMembers[c];
+}
+
+NeuroState NeuroPopulation::GetBaseline(size_t agent) const {
+    NeuroState s{};
+    for (int c = 0; c < NEURO_CHANNELS; ++c) s.*kMembers[c] = BaselineChannel(c)[agent];
+    return s;
+}
+
+void NeuroPopulation::SetBaseline(size_t agent, const NeuroState& state) {
+    for (int c = 0; c < NEURO_CHANNELS; ++c) BaselineChannel(c)[agent] = state.*kMembers[c];
+}
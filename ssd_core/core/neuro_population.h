@@ -0,0 +1,67 @@
+﻿#pragma once
+#include "neuro_core.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+// ホルモン成分（NeuroState のメンバ順）
+enum NeuroChannel : int32_t {
+  NEURO_DA = 0,
+  NEURO_S5,
+  NEURO_NE,
+  NEURO_AD,
+  NEURO_END,
+  NEURO_OXT,
+  NEURO_CORT,
+  NEURO_CHANNELS
+};
+
+// 多数のエージェントの神経状態（成分ごとの連続配列、SoA）
+//
+// 各成分の現在値と基準値をエージェント数ぶんの float 配列に並べ、長さを SIMD 幅
+// （kLanes）の倍数に切り上げて 32B 境界に置く。TickAll は全エージェントの基準値への
+// 緩和を成分ごとに1本の配列走査で行い（AVX があれば8体ずつ）、各エージェントを
+// NeuroCore::Tick で更新した場合とビット一致する。時定数は成分ごとに集団で共通。
+// 切り上げで増えた末尾のレーンは値0・基準値0のまま走査に含める
+struct NeuroPopulation {
+  static constexpr size_t kLanes = 8;
+
+  // 時定数（秒、NeuroCore と同じ既定値）
+  float tau[NEURO_CHANNELS] = {30.0f, 45.0f, 20.0f, 8.0f, 40.0f, 35.0f, 120.0f};
+
+  // count 体（全員 NeuroState の既定値）
+  explicit NeuroPopulation(size_t count);
+
+  size_t Size() const { return count; }
+  // 1成分の配列の長さ（kLanes の倍数）
+  size_t Stride() const { return stride; }
+
+  void TickAll(float dt_sec);
+  // 未登録の名前・範囲外の agent / id は無視
+  void ApplyEvent(size_t agent, std::string_view event_id);
+  void ApplyEvent(size_t agent, int32_t event_id);
+  // agents[k] に event_ids[k]（NeuroEvents() の id）を k の順に適用する
+  void ApplyEvents(const int32_t* agents, const int32_t* event_ids, size_t n);
+
+  NeuroState Get(size_t agent) const;
+  void Set(size_t agent, const NeuroState& state);
+  NeuroState GetBaseline(size_t agent) const;
+  void SetBaseline(size_t agent, const NeuroState& state);
+
+  // 成分 c の現在値・基準値の配列（長さ Stride()）
+  float* Channel(int c) { return data.get() + (size_t)c * stride; }
+  const float* Channel(int c) const { return data.get() + (size_t)c * stride; }
+  float* BaselineChannel(int c) { return Channel(NEURO_CHANNELS + c); }
+  const float* BaselineChannel(int c) const { return Channel(NEURO_CHANNELS + c); }
+
+private:
+  struct AlignedDelete {
+    void operator()(float* p) const;
+  };
+
+  size_t count;
+  size_t stride;
+  std::unique_ptr<float[], AlignedDelete> data;  /* 現在値 × 7 成分、基準値 × 7 成分 */
+};
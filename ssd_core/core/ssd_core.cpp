@@ -1,90 +1,461 @@
 ﻿#include "ssd_core.h"
+#include "ssd_step_impl.h"
 
-#include <vector>
-#include <random>
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <limits>
+#include <type_traits>
 
-struct SSDHandle {
-    int N;
-    int current;
-    std::vector<double> kappa; /* N*N */
-    std::vector<double> w;     /* N*N */
-    double E, F, T;
-    std::vector<double> pi;    /* size N */
-    SSDParams prm;
-    std::mt19937_64 rng;
-    std::normal_distribution<double> norm01;
-    std::uniform_real_distribution<double> uni01;
-
-    SSDHandle(int n, const SSDParams& p, uint64_t seed)
-        : N(n), current(0), kappa(n*n, 0.0), w(n*n, 0.0),
-          E(0.0), F(0.0), T(p.T0), pi(n, 1.0 / std::max(1,n)),
-          prm(p), rng(seed), norm01(0.0, 1.0), uni01(0.0, 1.0) {}
-};
-
-/* --- ヘルパー関数 --- */
-static inline double clip(double x, double lo, double hi) {
-    return x < lo ? lo : (x > hi ? hi : x);
-}
-
-static inline int idx(int i, int j, int N) { 
-    return i * N + j; 
-}
-
-static void softmax_temp(const std::vector<double>& logits, double T, std::vector<double>& out) {
-    int n = (int)logits.size();
-    out.resize(n);
-    if (n == 0) return;
-    
-    if (T <= 1e-8) {
-        // argmax one-hot
-        int arg = 0;
-        for (int i = 1; i < n; ++i) {
-            if (logits[i] > logits[arg]) arg = i;
+/* --- 密行列バックエンド --- */
+
+// 遅延アフィン変換の再正規化範囲（格納値の桁あふれ・精度低下を防ぐ）
+static const double kLazyScaleMin = 1e-8;
+static const double kLazyScaleMax = 1e8;
+// Σ, Σ^2 の厳密な再集計間隔（遅延ステップ数）
+static const uint32_t kLazyResumInterval = 4096;
+// 並列時の行ブロック: 1ブロックの kappa と j が L2 に収まる程度
+static const size_t kCacheBlockBytes = (size_t)256 << 10;
+// マッピング時（単一スレッド）の行ブロック: 1ブロックの kappa が約 16MB
+static const size_t kMappedBlockBytes = (size_t)16 << 20;
+
+template <class S>
+DenseGraphT<S>::DenseGraphT(int n, std::unique_ptr<SSDMappedFile> file, SSDThreadPool* p)
+    : N(n), backing(std::move(file)), relax_hist(SSD_RELAX_HIST_SIZE, 0),
+      align_kernel{ssd_select_align_kernel_t<S>(false), ssd_select_align_kernel_t<S>(true)},
+      step_count(0),
+      scale(1.0), offset(0.0), sum_s(0.0), sum_s2(0.0), lo(0.0), lazy_steps(0),
+      j_stale(false), j_scale(0.0), j_offset(0.0),
+      row_best(n, -1), row_epoch(n, 0), best_epoch(1), block_rows(0), pool(nullptr) {
+    size_t total = (size_t)n * n;
+    S zero = Traits::store(0.0f, 0);
+    if (backing) {
+        size_t region = ssd_mapped_round_up(total * sizeof(S));
+        kappa = SSDBuffer<S>(backing->at<S>(0), total);
+        w = SSDBuffer<S>(backing->at<S>(region), total);
+        j = SSDBuffer<J>(backing->at<J>(2 * region), total);
+    } else if (p) {
+        kappa = SSDBuffer<S>::uninitialized(total);
+        j = SSDBuffer<J>::uninitialized(total);
+    } else {
+        kappa = SSDBuffer<S>(total, zero);
+        j = SSDBuffer<J>(total, 0);
+    }
+    if (!backing) {
+        // w は触れた経路だけを持つ（1ノードあたり 8 経路分を先に確保）。
+        // その表が密な配列より大きくなる小さな N では最初から密な配列にする
+        size_t edges = (size_t)8 * n;
+        if (SSDEdgeMap<S>::bytes_for(edges) < total * sizeof(S)) {
+            w_edges.reserve(edges);
+        } else {
+            w = SSDBuffer<S>(total, zero);
+        }
+    }
+    set_pool(p);
+    if (!backing && p) {
+        // first touch: 各ブロックをステップで担当するスレッドが最初に書き込む
+        for_each_block([&](size_t, size_t begin, size_t end, int) {
+            std::fill(kappa.data() + begin, kappa.data() + end, zero);
+            std::fill(j.data() + begin, j.data() + end, (J)0);
+        });
+    }
+    j_pending.reserve(8);
+}
+
+template <class S>
+void DenseGraphT<S>::set_pool(SSDThreadPool* p) {
+    pool = p;
+    size_t bytes = pool ? kCacheBlockBytes : kMappedBlockBytes;
+    size_t row_bytes = (size_t)N * (pool ? sizeof(S) + sizeof(J) : sizeof(S));
+    block_rows = std::max<size_t>(1, bytes / std::max<size_t>(1, row_bytes));
+    worker_hist.assign(pool ? (size_t)pool->size() * SSD_RELAX_HIST_SIZE : 0, 0);
+}
+
+template <class S>
+size_t DenseGraphT<S>::block_count() const {
+    size_t block = block_rows * (size_t)N;
+    return ((size_t)N * N + block - 1) / block;
+}
+
+template <class S>
+typename DenseGraphT<S>::BlockPartial* DenseGraphT<S>::block_partials() {
+    // block_rows を変えたときだけ確保し直す
+    size_t nblocks = block_count();
+    if (partials.size() != nblocks) partials.resize(nblocks);
+    return partials.data();
+}
+
+template <class S>
+template <class Fn>
+void DenseGraphT<S>::for_each_block(Fn&& fn) {
+    // 捕捉は2つまで（std::function の内部バッファに収まり、呼ぶたびのヒープ確保が無い）
+    auto run = [this, &fn](size_t b0, size_t b1, int worker) {
+        size_t total = (size_t)N * N;
+        size_t block = block_rows * (size_t)N;
+        for (size_t b = b0; b < b1; ++b) {
+            fn(b, b * block, std::min((b + 1) * block, total), worker);
+        }
+    };
+    if (pool) {
+        pool->parallel_for(block_count(), run);
+    } else {
+        run(0, block_count(), 0);
+    }
+}
+
+template <class S>
+void DenseGraphT<S>::expand_j() {
+    // 遅延ステップの整合流を展開し、再配線済み経路は退避値で上書き
+    auto expand = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            j[i] = (J)(j_scale * Traits::load(kappa[i]) + j_offset);
         }
-        std::fill(out.begin(), out.end(), 0.0);
-        out[arg] = 1.0;
+    };
+    if (pool) {
+        for_each_block([&](size_t, size_t begin, size_t end, int) { expand(begin, end); });
+    } else {
+        expand(0, (size_t)N * N);
+    }
+    for (const auto& e : j_pending) {
+        j[e.first] = (J)e.second;
+    }
+    j_pending.clear();
+    j_stale = false;
+}
+
+template <class S>
+void DenseGraphT<S>::fold_transform() {
+    // 変換を格納値に畳み込み、恒等変換に戻す
+    auto fold = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            kappa[i] = Traits::store((J)kappa_at(i), SSD_ROUND_NEAREST);
+        }
+    };
+    if (pool) {
+        for_each_block([&](size_t, size_t begin, size_t end, int) { fold(begin, end); });
+    } else {
+        fold(0, (size_t)N * N);
+    }
+    scale = 1.0;
+    offset = 0.0;
+    resum();
+    invalidate_rows();  // 丸めで同値が生じ得る
+}
+
+template <class S>
+void DenseGraphT<S>::resum() {
+    // 差分更新で積もった丸め誤差を捨て、格納値から Σ, Σ^2 を取り直す
+    auto sum_range = [&](size_t begin, size_t end, double& s1, double& s2) {
+        for (size_t i = begin; i < end; ++i) {
+            double k = Traits::load(kappa[i]);
+            s1 += k;
+            s2 += k * k;
+        }
+    };
+    double s1 = 0.0, s2 = 0.0;
+    if (pool) {
+        // ブロックの部分和をブロック順に足す（スレッド数に依らない）
+        BlockPartial* part = block_partials();
+        for_each_block([&](size_t b, size_t begin, size_t end, int) {
+            part[b].sums.kappa_sum = 0.0;
+            part[b].sums.kappa_sq_sum = 0.0;
+            sum_range(begin, end, part[b].sums.kappa_sum, part[b].sums.kappa_sq_sum);
+        });
+        for (size_t b = 0; b < block_count(); ++b) {
+            s1 += part[b].sums.kappa_sum;
+            s2 += part[b].sums.kappa_sq_sum;
+        }
+    } else {
+        sum_range(0, (size_t)N * N, s1, s2);
+    }
+    sum_s = s1;
+    sum_s2 = s2;
+    lazy_steps = 0;
+}
+
+template <class S>
+void DenseGraphT<S>::invalidate_rows() {
+    if (++best_epoch == 0) {
+        // 世代の一巡: 古い世代番号と衝突しないよう全行を未計算に戻す
+        std::fill(row_epoch.begin(), row_epoch.end(), 0u);
+        best_epoch = 1;
+    }
+}
+
+template <class S>
+AlignKernelResult DenseGraphT<S>::align_update(SSDHandle& h, double p, double dt) {
+    const SSDParams& prm = h.prm;
+    size_t total = (size_t)N * N;
+
+    // j = j0 + j1*kappa。j^2 の係数 eta*rho*j1^2 が 0 なら更新はアフィン
+    double j0 = prm.G0 * p;
+    double j1 = prm.g * p;
+    if (prm.eps_noise <= 0.0 && prm.eta * prm.rho * j1 * j1 == 0.0) {
+        double m = 1.0 + (prm.eta * (p * j1 - 2.0 * prm.rho * j0 * j1) - prm.lam) * dt;
+        double c = (prm.eta * (p * j0 - prm.rho * j0 * j0) + prm.lam * prm.kappa_min) * dt;
+        double lo_next = m * lo + c;
+        double tol = 1e-12 * std::max(1.0, std::abs(prm.kappa_min));
+
+        // m > 0 で写像は単調なので、下界でクリップが発動しなければ全経路で発動しない
+        if (m > 0.0 && lo_next >= prm.kappa_min - tol) {
+            // 遅延ステップが続く間も一定間隔で厳密に再集計する（償却 O(N^2 / 間隔)）
+            if (++lazy_steps >= kLazyResumInterval) resum();
+
+            double n = (double)total;
+            double sum_k = scale * sum_s + n * offset;
+            double sum_k2 = scale * scale * sum_s2 + 2.0 * scale * offset * sum_s + n * offset * offset;
+
+            AlignKernelResult r;
+            r.J_sq = std::max(n * j0 * j0 + 2.0 * j0 * j1 * sum_k + j1 * j1 * sum_k2, 0.0);
+            r.kappa_sum = m * sum_k + n * c;
+            r.kappa_sq_sum = std::max(m * m * sum_k2 + 2.0 * m * c * sum_k + n * c * c, 0.0);
+
+            j_stale = true;
+            invalidate_rows();
+            j_scale = j1 * scale;
+            j_offset = j0 + j1 * offset;
+            j_pending.clear();
+
+            scale *= m;
+            offset = m * offset + c;
+            lo = std::max(lo_next, prm.kappa_min);
+
+            if (scale < kLazyScaleMin || scale > kLazyScaleMax) {
+                expand_j();
+                fold_transform();
+            }
+            return r;
+        }
+    }
+
+    // 通常経路: 変換を畳み込んでから融合カーネルで全経路を更新
+    if (scale != 1.0 || offset != 0.0) fold_transform();
+    j_stale = false;
+    j_pending.clear();
+
+    AlignKernelArgs args{prm.G0, prm.g, p, prm.eta, prm.rho, prm.lam, prm.kappa_min, dt};
+    AlignKernelResult r;
+    if (backing || pool) {
+        r = align_blocked(h, args, prm.eps_noise > 0.0);
+    } else {
+        // ノイズは一括生成して先に jバッファに書いておく
+        bool noisy = prm.eps_noise > 0.0;
+        if (noisy) h.rng.fill_edge_noise(j.data(), total, prm.eps_noise);
+        uint32_t step = step_count;
+        if constexpr (!std::is_same<S, double>::value) step_count++;
+        r = align_kernel[noisy](args, kappa.data(), j.data(), j.data(), total, step, 0);
+    }
+    sum_s = r.kappa_sum;
+    sum_s2 = r.kappa_sq_sum;
+    lazy_steps = 0;
+    invalidate_rows();
+    lo = prm.kappa_min;  // クリップ後は全経路 kappa_min 以上
+    return r;
+}
+
+template <class S>
+AlignKernelResult DenseGraphT<S>::align_blocked(SSDHandle& h, const AlignKernelArgs& args,
+                                                bool noisy) {
+    // 行ブロックごとにノイズ生成と融合カーネルを行い（並列時は作業スレッドで分担）、
+    // ブロックの部分和をブロック順に足す。ノイズの鍵と dither はステップ単位なので
+    // 一括処理と同じ値になり、違いはブロック間の総和の丸め誤差だけ。
+    // マッピング時は処理中に次のブロックを先読みさせる
+    size_t total = (size_t)N * N;
+    size_t block = block_rows * (size_t)N;
+    uint64_t key = noisy ? h.rng.normal_key() : 0;
+    uint32_t step = step_count;
+    if constexpr (!std::is_same<S, double>::value) step_count++;
+
+    const SSDRandom& rng = h.rng;
+    double eps_noise = h.prm.eps_noise;
+    SSDAlignKernel<S> kernel = align_kernel[noisy];
+    BlockPartial* part = block_partials();
+    for_each_block([&](size_t b, size_t begin, size_t end, int) {
+        if (backing && end < total) {
+            size_t next = std::min(block, total - end);
+            backing->will_need(kappa.data() + end, next * sizeof(S));
+            backing->will_need(j.data() + end, next * sizeof(J));
+        }
+
+        if (noisy) rng.fill_edge_noise_keyed(key, j.data(), begin, end, eps_noise, 1);
+        part[b].sums = kernel(args, kappa.data() + begin, j.data() + begin, j.data() + begin,
+                              end - begin, step, begin);
+    });
+
+    AlignKernelResult r{0.0, 0.0, 0.0};
+    for (size_t b = 0; b < block_count(); ++b) {
+        r.J_sq += part[b].sums.J_sq;
+        r.kappa_sum += part[b].sums.kappa_sum;
+        r.kappa_sq_sum += part[b].sums.kappa_sq_sum;
+    }
+    return r;
+}
+
+template <class S>
+void DenseGraphT<S>::row_values(int row, double* out, int len) const {
+    copy_block(row, 0, 1, std::min(N, len), out);
+}
+
+template <class S>
+void DenseGraphT<S>::copy_block(int row0, int col0, int nrows, int ncols, double* out) const {
+    for (int r = 0; r < nrows; ++r) {
+        size_t base = (size_t)(row0 + r) * N + col0;
+        double* dst = out + (size_t)r * ncols;
+        if constexpr (std::is_same<S, double>::value) {
+            if (scale == 1.0 && offset == 0.0) {
+                std::memcpy(dst, kappa.data() + base, sizeof(double) * ncols);
+                continue;
+            }
+        }
+        for (int k = 0; k < ncols; ++k) {
+            dst[k] = kappa_at(base + k);
+        }
+    }
+}
+
+template <class S>
+void DenseGraphT<S>::add_edge(int row, int col, double d_kappa, double d_w) {
+    size_t edge_idx = (size_t)row * N + col;
+    // 表を広げると密な配列より大きくなるなら密な配列に切り替える
+    if (w.size() == 0 && w_edges.will_grow() &&
+        SSDEdgeMap<S>::bytes_for(2 * w_edges.size()) >= (size_t)N * N * sizeof(S)) {
+        w_dense();
+    }
+    S& w_edge = w.size() ? w[edge_idx] : w_edges.at(edge_idx, Traits::store(0.0f, 0));
+    w_edge = Traits::store((J)(Traits::load(w_edge) + d_w), SSD_ROUND_NEAREST);
+
+    double s_old = Traits::load(kappa[edge_idx]);
+    if (j_stale) {
+        // 展開前の j は更新前の格納値から求まるので、書き換える前に退避
+        bool saved = false;
+        for (const auto& e : j_pending) saved = saved || e.first == edge_idx;
+        if (!saved) j_pending.emplace_back(edge_idx, j_scale * s_old + j_offset);
+    }
+
+    // 恒等変換なら s_old + d_kappa そのもの
+    double k_new = (scale * s_old + offset) + d_kappa;
+    kappa[edge_idx] = Traits::store((J)((k_new - offset) / scale), SSD_ROUND_NEAREST);
+    double s_new = Traits::load(kappa[edge_idx]);
+    sum_s += s_new - s_old;
+    sum_s2 += s_new * s_new - s_old * s_old;
+    lo = std::min(lo, k_new);
+
+    row_epoch[row] = 0;  // 同着の幅が変わり得るので次回に走査し直す
+}
+
+template <class S>
+void DenseGraphT<S>::relax_top(size_t count, double eps, double kappa_min) {
+    if (j_stale) expand_j();
+    if (scale != 1.0 || offset != 0.0) fold_transform();
+
+    invalidate_rows();
+
+    // 索引配列のソートではなく基数選択で閾値を求める
+    size_t total = (size_t)N * N;
+    RelaxCut cut;
+    if (pool) {
+        // 桁ごとのヒストグラムは作業者ごとに数えて足す（整数なので順序に依らない）
+        cut = ssd_relax_select(count, relax_hist.data(),
+            [&](uint64_t prefix, uint64_t mask, int shift, uint64_t digit_mask, uint64_t* hist) {
+                std::fill(worker_hist.begin(), worker_hist.end(), 0);
+                for_each_block([&](size_t, size_t begin, size_t end, int worker) {
+                    ssd_relax_count_digits(j.data() + begin, end - begin, prefix, mask, shift,
+                                           digit_mask,
+                                           worker_hist.data() + (size_t)worker * SSD_RELAX_HIST_SIZE);
+                });
+                for (int wk = 0; wk < pool->size(); ++wk) {
+                    const uint64_t* wh = worker_hist.data() + (size_t)wk * SSD_RELAX_HIST_SIZE;
+                    for (uint64_t d = 0; d <= digit_mask; ++d) hist[d] += wh[d];
+                }
+            });
+    } else {
+        cut = ssd_relax_threshold(j.data(), total, count, relax_hist.data());
+    }
+
+    // 閾値より大きい経路と、閾値と同値の経路を添字の小さい順に ties 件緩和する
+    auto relax_range = [&](size_t begin, size_t end, uint64_t ties, double& s1, double& s2,
+                           double& lo_acc) {
+        ssd_relax_for_each(j.data(), begin, end, cut.key, ties, [&](size_t i) {
+            double old_kappa = Traits::load(kappa[i]);
+            kappa[i] = Traits::store((J)std::max(old_kappa - eps, kappa_min), SSD_ROUND_NEAREST);
+            double new_kappa = Traits::load(kappa[i]);
+            s1 += new_kappa - old_kappa;
+            s2 += new_kappa * new_kappa - old_kappa * old_kappa;
+            lo_acc = std::min(lo_acc, new_kappa);
+        });
+    };
+    if (!pool) {
+        relax_range(0, total, cut.ties, sum_s, sum_s2, lo);
         return;
     }
-    
-    // 数値安定化のため最大値を引く
-    double maxv = *std::max_element(logits.begin(), logits.end());
-    
-    // exp計算と正規化
-    double sum = 0.0;
-    for (int i = 0; i < n; ++i) {
-        double z = (logits[i] - maxv) / T;
-        double e = std::exp(z);
-        out[i] = e;
-        sum += e;
+
+    // 同値の割り当て: ブロックごとの同値数を数え、先頭のブロックから順に配る
+    BlockPartial* part = block_partials();
+    size_t nblocks = block_count();
+    if (cut.ties > 0) {
+        for_each_block([&](size_t b, size_t begin, size_t end, int) {
+            uint64_t n = 0;
+            for (size_t i = begin; i < end; ++i) n += ssd_relax_key(j[i]) == cut.key;
+            part[b].ties = n;
+        });
     }
-    
-    if (sum <= 0.0) sum = 1.0;
-    for (int i = 0; i < n; ++i) {
-        out[i] /= sum;
+    uint64_t ties_left = cut.ties;
+    for (size_t b = 0; b < nblocks; ++b) {
+        uint64_t take = ties_left > 0 ? std::min(ties_left, part[b].ties) : 0;
+        part[b].ties = take;
+        ties_left -= take;
+    }
+
+    for_each_block([&](size_t b, size_t begin, size_t end, int) {
+        part[b].sums.kappa_sum = 0.0;
+        part[b].sums.kappa_sq_sum = 0.0;
+        part[b].lo = std::numeric_limits<double>::infinity();
+        relax_range(begin, end, part[b].ties, part[b].sums.kappa_sum, part[b].sums.kappa_sq_sum,
+                    part[b].lo);
+    });
+    for (size_t b = 0; b < nblocks; ++b) {
+        sum_s += part[b].sums.kappa_sum;
+        sum_s2 += part[b].sums.kappa_sq_sum;
+        lo = std::min(lo, part[b].lo);
     }
 }
 
-static double entropy_norm(const std::vector<double>& p) {
-    int n = (int)p.size();
-    if (n == 0) return 0.0;
-    
-    double H = 0.0;
-    for (int i = 0; i < n; ++i) {
-        double x = p[i] <= 1e-12 ? 1e-12 : p[i];
-        H += -x * std::log(x);
+template <class S>
+SSDBuffer<S>& DenseGraphT<S>::w_dense() {
+    if (w.size() == 0) {
+        w = SSDBuffer<S>((size_t)N * N, Traits::store(0.0f, 0));
+        w_edges.for_each([&](uint64_t i, const S& v) { w[i] = v; });
+        w_edges.clear();
     }
-    
-    double Hmax = std::log((double)n);
-    return Hmax > 0.0 ? (H / Hmax) : 0.0;
+    return w;
 }
 
+template <class S>
+int DenseGraphT<S>::argmax_row(int row) const {
+    if (row_epoch[row] == best_epoch) return row_best[row];
+
+    size_t base = (size_t)row * N;
+    int best = ssd_argmax_pick(row, N, [&](int k) { return kappa_at(base + k); });
+
+    row_best[row] = best;
+    row_epoch[row] = best_epoch;
+    return best;
+}
+
+template struct DenseGraphT<double>;
+template struct DenseGraphT<float>;
+template struct DenseGraphT<SSDbf16>;
+
 /* --- API実装 --- */
 
-extern "C" SSDHandle* ssd_create(int32_t N, const SSDParams* params, uint64_t seed) {
+// mapped_path が非NULLなら密行列をそのファイルのマッピング上に置く
+static SSDHandle* create_handle(int32_t N, const SSDParams* params, uint64_t seed,
+                                const SSDCreateOptions& opts, const char* mapped_path = nullptr) {
     if (N <= 0) return nullptr;
+    if (opts.storage < SSD_STORAGE_F64 || opts.storage > SSD_STORAGE_BF16) return nullptr;
+    if (opts.rng != SSD_RNG_MT19937 && opts.rng != SSD_RNG_PHILOX) return nullptr;
+    if (mapped_path && opts.sparse) return nullptr;
+    if (opts.telemetry_ring < 0) return nullptr;
     
     SSDParams p;
     if (params) {
@@ -93,15 +464,57 @@ extern "C" SSDHandle* ssd_create(int32_t N, const SSDParams* params, uint64_t se
         // デフォルトパラメータ（構造体初期化で既に設定済み）
     }
     
+    // 疎グラフは未接触経路が同一写像に従う前提なので経路ノイズを表せない
+    if (opts.sparse && p.eps_noise > 0.0) return nullptr;
+
     if (seed == 0) seed = 123456789ULL;
     
     try {
-        return new SSDHandle(N, p, seed);
+        std::unique_ptr<SSDMappedFile> backing;
+        if (mapped_path) {
+            size_t bytes = opts.storage == SSD_STORAGE_F32 ? DenseGraphT<float>::mapped_bytes(N)
+                         : opts.storage == SSD_STORAGE_BF16 ? DenseGraphT<SSDbf16>::mapped_bytes(N)
+                         : DenseGraph::mapped_bytes(N);
+            backing = SSDMappedFile::create(mapped_path, bytes);
+            if (!backing) return nullptr;
+        }
+        SSDHandle* h = new SSDHandle(N, p, seed, opts, std::move(backing));
+        h->H = entropy_norm(h->pi.data(), N);
+        return h;
     } catch (...) {
         return nullptr;
     }
 }
 
+extern "C" SSDHandle* ssd_create(int32_t N, const SSDParams* params, uint64_t seed) {
+    return create_handle(N, params, seed, SSDCreateOptions());
+}
+
+extern "C" SSDHandle* ssd_create_sparse(int32_t N, const SSDParams* params, uint64_t seed) {
+    SSDCreateOptions opts;
+    opts.sparse = 1;
+    return create_handle(N, params, seed, opts);
+}
+
+extern "C" SSDHandle* ssd_create_ex(int32_t N, const SSDParams* params, uint64_t seed,
+                                    const SSDCreateOptions* options) {
+    SSDCreateOptions opts;
+    if (options) {
+        std::memcpy(&opts, options, sizeof(SSDCreateOptions));
+    }
+    return create_handle(N, params, seed, opts);
+}
+
+extern "C" SSDHandle* ssd_create_mapped(const char* path, int32_t N, const SSDParams* params,
+                                        uint64_t seed, const SSDCreateOptions* options) {
+    if (!path) return nullptr;
+    SSDCreateOptions opts;
+    if (options) {
+        std::memcpy(&opts, options, sizeof(SSDCreateOptions));
+    }
+    return create_handle(N, params, seed, opts, path);
+}
+
 extern "C" void ssd_destroy(SSDHandle* h) {
     delete h;
 }
@@ -111,9 +524,27 @@ extern "C" void ssd_get_params(SSDHandle* h, SSDParams* out) {
     std::memcpy(out, &h->prm, sizeof(SSDParams));
 }
 
-extern "C" void ssd_set_params(SSDHandle* h, const SSDParams* in) {
-    if (!h || !in) return;
+extern "C" int32_t ssd_set_params(SSDHandle* h, const SSDParams* in) {
+    if (!h || !in) return 0;
+    if (h->sparse && in->eps_noise > 0.0) return 0;
     std::memcpy(&h->prm, in, sizeof(SSDParams));
+    if (h->recorder) h->recorder->params(h->prm);
+    return 1;
+}
+
+extern "C" void ssd_set_threads(SSDHandle* h, int32_t threads) {
+    if (!h || h->sparse) return;
+    try {
+        // 新しいプールを渡してから古いプールを破棄する
+        std::unique_ptr<SSDThreadPool> pool(threads == 1 ? nullptr : new SSDThreadPool(threads));
+        if (h->dense_f32) h->dense_f32->set_pool(pool.get());
+        else if (h->dense_bf16) h->dense_bf16->set_pool(pool.get());
+        else h->dense.set_pool(pool.get());
+        h->pool = std::move(pool);
+        if (h->recorder) h->recorder->threads(threads);
+    } catch (...) {
+        // スレッド生成に失敗したら現在のプールのまま続行
+    }
 }
 
 extern "C" int32_t ssd_get_N(SSDHandle* h) {
@@ -123,186 +554,141 @@ extern "C" int32_t ssd_get_N(SSDHandle* h) {
 extern "C" int32_t ssd_get_kappa_row(SSDHandle* h, int32_t row, double* out_buf, int32_t len) {
     if (!h || !out_buf || row < 0 || row >= h->N) return 0;
     
-    int N = h->N;
-    int m = std::min(N, (int)len);
-    std::memcpy(out_buf, h->kappa.data() + row * N, sizeof(double) * m);
+    int m = std::min(h->N, (int)len);
+    if (m <= 0) return 0;
+    ssd_visit_graph(h, [&](auto& graph) { graph.row_values(row, out_buf, m); });
     return m;
 }
 
+template <class S>
+static int32_t storage_of() {
+    if (std::is_same<S, float>::value) return SSD_STORAGE_F32;
+    if (std::is_same<S, SSDbf16>::value) return SSD_STORAGE_BF16;
+    return SSD_STORAGE_F64;
+}
+
+// which: 0 = kappa, 1 = w
+static int32_t matrix_view(SSDHandle* h, int which, SSDMatrixView* out) {
+    if (!h || !out) return -1;
+    try {
+        return ssd_visit_graph(h, [&](auto& graph) -> int32_t {
+            using G = typename std::decay<decltype(graph)>::type;
+            if constexpr (std::is_same<G, SparseGraph>::value) {
+                return -1;  // 疎グラフは行列を持たない
+            } else {
+                using S = typename std::decay<decltype(graph.kappa[0])>::type;
+                out->data = which == 0 ? (const void*)graph.kappa.data()
+                                       : (const void*)graph.w_dense().data();
+                out->rows = graph.N;
+                out->cols = graph.N;
+                out->stride = graph.N;
+                out->elem_type = storage_of<S>();
+                out->scale = which == 0 ? graph.scale : 1.0;
+                out->offset = which == 0 ? graph.offset : 0.0;
+                out->generation = h->generation;
+                return 0;
+            }
+        });
+    } catch (...) {
+        return -1;  // 密な w を確保できない
+    }
+}
+
+extern "C" int32_t ssd_get_kappa_view(SSDHandle* h, SSDMatrixView* out) {
+    return matrix_view(h, 0, out);
+}
+
+extern "C" int32_t ssd_get_w_view(SSDHandle* h, SSDMatrixView* out) {
+    return matrix_view(h, 1, out);
+}
+
+extern "C" int32_t ssd_drain_telemetry(SSDHandle* h, SSDTelemetry* out, int32_t max) {
+    if (!h || !h->ring || !out || max <= 0) return 0;
+    return (int32_t)h->ring->drain(out, (size_t)max);
+}
+
+extern "C" uint64_t ssd_get_telemetry_dropped(SSDHandle* h) {
+    if (!h || !h->ring) return 0;
+    return h->ring->dropped.load(std::memory_order_relaxed);
+}
+
+extern "C" uint64_t ssd_get_step(SSDHandle* h) {
+    return h ? h->rng.step : 0;
+}
+
+extern "C" int32_t ssd_get_state(SSDHandle* h, SSDStateView* out) {
+    if (!h || !out) return -1;
+    out->E = h->E;
+    out->T = h->T;
+    out->F = h->F;
+    out->kappa_mean = h->kappa_mean;
+    out->step = h->rng.step;
+    out->current = h->current;
+    return 0;
+}
+
+extern "C" uint64_t ssd_get_generation(SSDHandle* h) {
+    return h ? h->generation : 0;
+}
+
+extern "C" int64_t ssd_copy_kappa_block(SSDHandle* h, int32_t row0, int32_t col0, int32_t rows,
+                                        int32_t cols, double* out) {
+    if (!h || !out || row0 < 0 || col0 < 0 || rows < 0 || cols < 0) return -1;
+    if (rows > h->N - row0 || cols > h->N - col0) return -1;
+    if (rows == 0 || cols == 0) return 0;
+
+    ssd_visit_graph(h, [&](auto& graph) { graph.copy_block(row0, col0, rows, cols, out); });
+    return (int64_t)rows * cols;
+}
+
 extern "C" void ssd_step(SSDHandle* h, double p, double dt, SSDTelemetry* out) {
     if (!h) return;
-    
-    int N = h->N;
-    auto& prm = h->prm;
 
-    // === 1. AlignFlow（整合流計算） ===
-    // j = (G0 + g*kappa) * p + noise
-    std::vector<double> j(N * N, 0.0);
-    double J_norm = 0.0;
-    
-    for (int i = 0; i < N * N; ++i) {
-        double val = (prm.G0 + prm.g * h->kappa[i]) * p;
-        
-        // ノイズ追加（オプション）
-        if (prm.eps_noise > 0.0) {
-            val += prm.eps_noise * h->norm01(h->rng);
-        }
-        
-        j[i] = val;
-        J_norm += val * val;
-    }
-    J_norm = std::sqrt(J_norm);
-
-    // === 2. UpdateKappa（整合慣性更新） ===
-    for (int i = 0; i < N * N; ++i) {
-        // 整合仕事: p*j - rho*j^2
-        double align_work = p * j[i] - prm.rho * j[i] * j[i];
-        double gain = prm.eta * align_work;
-        double decay = prm.lam * (h->kappa[i] - prm.kappa_min);
-        
-        double new_kappa = h->kappa[i] + (gain - decay) * dt;
-        h->kappa[i] = std::max(new_kappa, prm.kappa_min);
+    ssd_visit_graph(h, [&](auto& graph) { ssd_step_impl(h, graph, p, dt, out); });
+}
+
+// steps 回のステップをグラフ表現の分岐1回で回し、間引いたテレメトリを書き出す
+template <class Graph, class Pressure>
+static int32_t step_n_impl(SSDHandle* h, Graph& graph, const Pressure& pressure, int32_t steps,
+                           double dt, SSDTelemetry* out, int32_t stride) {
+    int32_t written = 0;
+    SSDTelemetry tel;
+    for (int32_t t = 0; t < steps; ++t) {
+        ssd_step_impl(h, graph, pressure(t), dt, &tel);
+        bool record = tel.did_jump || (stride > 0 && (t + 1) % stride == 0);
+        if (record && out) out[written++] = tel;
     }
+    return written;
+}
 
-    // === 3. UpdateHeat（熱蓄積更新） ===
-    double excess_pressure = std::max(std::abs(p) - J_norm, 0.0);
-    double dE = prm.alpha * excess_pressure - prm.beta_E * h->E;
-    h->E = std::max(h->E + dE * dt, 0.0);
+template <class Pressure>
+static int32_t step_n(SSDHandle* h, const Pressure& pressure, int32_t steps, double dt,
+                      SSDTelemetry* out, int32_t stride) {
+    return ssd_visit_graph(h, [&](auto& graph) {
+        return step_n_impl(h, graph, pressure, steps, dt, out, stride);
+    });
+}
 
-    // === 4. Threshold / JumpRate / Temperature ===
-    // 平均慣性計算
-    double kappa_mean = 0.0;
-    for (double k : h->kappa) kappa_mean += k;
-    kappa_mean /= (double)(N * N);
+extern "C" int32_t ssd_step_n(SSDHandle* h, const double* p, int32_t steps, double dt,
+                              SSDTelemetry* out, int32_t telemetry_stride) {
+    if (!h || !p || steps <= 0) return 0;
 
-    // 動的閾値
-    double Theta = prm.Theta0 + prm.a1 * kappa_mean - prm.a2 * h->F;
-    
-    // 跳躍率（ポアソン過程）
-    double hrate = prm.h0 * std::exp((h->E - Theta) / std::max(1e-8, prm.gamma));
-    
-    // 探索温度（硬直検知付き）
-    double policy_entropy = h->pi.empty() ? 1.0 : entropy_norm(h->pi);
-    h->T = std::max(1e-6, prm.T0 + prm.c1 * h->E - prm.c2 * policy_entropy);
-
-    // === 5. 跳躍判定と実行 ===
-    bool did_jump = false;
-    int rewired_to = h->current;
-
-    double jump_probability = 1.0 - std::exp(-hrate * dt);
-    if (h->uni01(h->rng) < jump_probability) {
-        did_jump = true;
-        
-        // === 制約付きランダム接続 ===
-        // 現在ノードから他のノードへの接続確率を計算
-        std::vector<double> logits(N, 0.0);
-        for (int k = 0; k < N; ++k) {
-            // 既存の慣性をベースとする
-            logits[k] = h->kappa[idx(h->current, k, N)];
-            
-            // 自己接続を抑制
-            if (k == h->current) {
-                logits[k] -= 1.0;
-            }
-            
-            // ガウスノイズ追加
-            logits[k] += prm.sigma * h->norm01(h->rng);
-        }
-        
-        // ソフトマックスで確率分布を計算
-        softmax_temp(logits, h->T, h->pi);
-        
-        // カテゴリカル分布からサンプリング
-        double r = h->uni01(h->rng);
-        double cdf = 0.0;
-        int selected = N - 1;  // フォールバック
-        for (int k = 0; k < N; ++k) {
-            cdf += h->pi[k];
-            if (r <= cdf) {
-                selected = k;
-                break;
-            }
-        }
-        
-        // === Rewire（再配線） ===
-        int edge_idx = idx(h->current, selected, N);
-        h->w[edge_idx] += prm.delta_w;
-        h->kappa[edge_idx] += prm.delta_kappa;
-        
-        // 放熱
-        h->E *= prm.c0_cool;
-        
-        // 位置更新
-        h->current = selected;
-        rewired_to = selected;
-
-        // === RelaxTop（硬直ほぐし） ===
-        int total_edges = N * N;
-        int relax_count = std::max(1, (int)std::round(prm.q_relax * total_edges));
-        
-        // 流量の絶対値でソート用インデックスを作成
-        std::vector<int> indices(total_edges);
-        for (int i = 0; i < total_edges; ++i) indices[i] = i;
-        
-        std::partial_sort(indices.begin(), indices.begin() + relax_count, indices.end(),
-            [&](int a, int b) { return std::abs(j[a]) > std::abs(j[b]); });
-        
-        // 上位q%の経路を微緩和
-        for (int i = 0; i < relax_count; ++i) {
-            int pos = indices[i];
-            double new_kappa = h->kappa[pos] - prm.eps_relax;
-            h->kappa[pos] = std::max(new_kappa, prm.kappa_min);
-        }
-        
-    } else {
-        // === ε-greedy完全ランダム探索 ===
-        double eps = prm.eps0 + prm.d1 * h->E - prm.d2 * kappa_mean;
-        eps = clip(eps, 0.0, 1.0);
-        
-        if (h->uni01(h->rng) < eps) {
-            int k = (int)std::floor(h->uni01(h->rng) * N);
-            if (k == N) k = N - 1;
-            
-            if (k != h->current) {
-                int edge_idx = idx(h->current, k, N);
-                h->w[edge_idx] += 0.05;  // 小さな重み追加
-                h->kappa[edge_idx] += 0.05;  // 小さな慣性追加
-            }
-        }
-        
-        // === 決定論的行動選択 ===
-        // 現在位置から最も慣性の高い接続先を選択
-        int best = h->current;
-        double best_value = -1e300;
-        
-        for (int k = 0; k < N; ++k) {
-            double value = h->kappa[idx(h->current, k, N)];
-            if (k == h->current) value -= 1e-6;  // 自己接続を微妙に抑制
-            
-            if (value > best_value) {
-                best_value = value;
-                best = k;
-            }
-        }
-        
-        h->current = best;
-        rewired_to = best;
-    }
+    return step_n(h, [p](int32_t t) { return p[t]; }, steps, dt, out, telemetry_stride);
+}
 
-    // === 6. テレメトリ出力 ===
-    if (out) {
-        double align_efficiency = (std::abs(p) > 1e-8) ? (J_norm / std::abs(p)) : 0.0;
-        
-        out->E = h->E;
-        out->Theta = Theta;
-        out->h = hrate;
-        out->T = h->T;
-        out->H = policy_entropy;
-        out->J_norm = J_norm;
-        out->align_eff = align_efficiency;
-        out->kappa_mean = kappa_mean;
-        out->current = h->current;
-        out->did_jump = did_jump ? 1 : 0;
-        out->rewired_to = rewired_to;
-    }
-}
\ No newline at end of file
+extern "C" int32_t ssd_step_n_interp(SSDHandle* h, const double* p_knots, int32_t knots,
+                                     int32_t steps, double dt, SSDTelemetry* out,
+                                     int32_t telemetry_stride) {
+    if (!h || !p_knots || knots <= 0 || steps <= 0) return 0;
+
+    // ステップ t の位置を節点座標 u = t*(knots-1)/(steps-1) に写して線形補間
+    double span = steps > 1 ? (double)(knots - 1) / (double)(steps - 1) : 0.0;
+    auto pressure = [p_knots, knots, span](int32_t t) {
+        double u = t * span;
+        int32_t k = std::min((int32_t)u, knots - 1);
+        if (k == knots - 1) return p_knots[k];
+        double f = u - k;
+        return p_knots[k] + (p_knots[k + 1] - p_knots[k]) * f;
+    };
+    return step_n(h, pressure, steps, dt, out, telemetry_stride);
+}
@@ -64,19 +64,168 @@ struct SSDTelemetry {
   int32_t rewired_to;
 };
 
+// ssd_get_state の結果（ステップを進めずに読める現在の状態）
+struct SSDStateView {
+  double E;
+  double T;
+  double F;
+  double kappa_mean;  // 直近のステップの kappa 平均（SSDTelemetry::kappa_mean と同じ値、作成直後は 0）
+  uint64_t step;      // ssd_get_step
+  int32_t current;    // 現在のノード
+};
+
+// kappa / w の格納精度（SSDCreateOptions::storage）
+enum {
+  SSD_STORAGE_F64 = 0,   // double（既定）
+  SSD_STORAGE_F32 = 1,   // float（メモリ・帯域 1/2）
+  SSD_STORAGE_BF16 = 2,  // bfloat16、演算は float（メモリ 1/4、整合流スクラッチは float）
+};
+
+// 乱数生成器（SSDCreateOptions::rng）
+enum {
+  SSD_RNG_MT19937 = 0,  // mt19937_64 から呼び出し順に引く（既定）
+  SSD_RNG_PHILOX = 1,   // Philox4x32-10。各乱数が (seed, ステップ数, 添字) で決まり分割に依らない
+};
+
+struct SSDCreateOptions {
+  int32_t storage = SSD_STORAGE_F64;
+  int32_t sparse = 0;  // 非0で疎グラフ（ssd_create_sparse と同じ、storage は無視）
+  int32_t rng = SSD_RNG_MT19937;
+  // >0 ならステップごとのテレメトリをこの件数（2の冪に切り上げ）のリングに溜め、
+  // 別スレッドから ssd_drain_telemetry で取り出せるようにする（0 で無効）
+  int32_t telemetry_ring = 0;
+  // 密行列ステップの作業スレッド数（呼び出しスレッドを含む、0 以下ならハードウェアスレッド数）。
+  // 1 以外では行ブロックを作業スレッドで分担し、結果はスレッド数に依らない
+  // （1 とは総和の丸め誤差を除いて一致）。疎グラフでは無視する
+  int32_t threads = 1;
+};
+
+// 行列ビュー（ssd_get_kappa_view / ssd_get_w_view）。格納値をコピーせずに直接参照する。
+// 要素 (r, c) の格納値は data + r*stride + c（型は elem_type、BF16 は float の上位16bit）、
+// 真値は scale*格納値 + offset（kappa は遅延アフィン変換中だけ 1 / 0 以外、w は常に 1 / 0）。
+// data・scale・offset は同じハンドルの次のステップ（ssd_step / ssd_step_n*）まで有効
+struct SSDMatrixView {
+  const void* data;
+  int32_t rows;
+  int32_t cols;
+  int64_t stride;       // 行の間隔（要素数）
+  int32_t elem_type;    // SSD_STORAGE_F64 / F32 / BF16
+  double scale;
+  double offset;
+  uint64_t generation;  // 取得時の ssd_get_generation
+};
+
 struct SSDHandle; // 不透明ハンドル
+struct SSDEnsemble; // 不透明ハンドル（アンサンブル）
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 SSD_API SSDHandle* ssd_create(int32_t N, const SSDParams* params, uint64_t seed);
+// 疎グラフ版: 未接触経路を暗黙の既定値（区間）で表し、触れた経路だけを保持する。
+// メモリ・ステップコストは N^2 ではなく接触経路数に比例。テレメトリは ssd_create と同一
+// （総和の丸め誤差を除く）。経路ノイズは扱えないので eps_noise > 0 のパラメータでは NULL を返す
+// （ssd_create_ex の sparse も同じ）。
+SSD_API SSDHandle* ssd_create_sparse(int32_t N, const SSDParams* params, uint64_t seed);
+// 作成オプション付き（options が NULL なら ssd_create と同じ）。未知の storage は NULL を返す。
+// F32 / BF16 では kappa の丸めにより軌道は double 版から許容誤差の範囲でずれる。
+// BF16 は1ステップの微小な更新が消えないよう確率的丸め（添字とステップから決定論的に生成）を用いる。
+SSD_API SSDHandle* ssd_create_ex(int32_t N, const SSDParams* params, uint64_t seed,
+                                 const SSDCreateOptions* options);
+// kappa / w（と同じ大きさの整合流スクラッチ）を path のファイルに mmap して置く版
+// （1行列が RAM を超える大きな N 向け）。ファイルは作業領域として作り直し（既存の内容は破棄）、
+// ssd_destroy 後も削除しない。通常ステップは行ブロックごとに処理し、先読みヒントで
+// ディスクから順に読み込ませる。options は ssd_create_ex と同じ（sparse は指定不可で NULL）。
+// 軌道は同じ設定の ssd_create_ex と総和の丸め誤差を除いて一致し、他の API はそのまま使える
+SSD_API SSDHandle* ssd_create_mapped(const char* path, int32_t N, const SSDParams* params,
+                                     uint64_t seed, const SSDCreateOptions* options);
 SSD_API void ssd_destroy(SSDHandle* h);
 SSD_API void ssd_step(SSDHandle* h, double p, double dt, SSDTelemetry* out);
+// 複数ステップをライブラリ内で連続実行する。p[t] が t 番目のステップの意味圧（steps 要素）。
+// テレメトリは telemetry_stride ステップごと（t+1 が stride の倍数）と跳躍ステップで
+// 記録順に out へ書き出し、書き出した件数を返す（stride <= 0 なら跳躍時のみ）。
+// out は最大 steps 件分必要（out が NULL なら書き出さない）。結果は ssd_step を steps 回
+// 呼んだ場合と同一。
+SSD_API int32_t ssd_step_n(SSDHandle* h, const double* p, int32_t steps, double dt,
+                           SSDTelemetry* out, int32_t telemetry_stride);
+// ssd_step_n の圧力スケジュール版。p_knots[0..knots) を steps ステップ全体に等間隔で
+// 配置し（先頭=ステップ0、末尾=ステップ steps-1）、各ステップの意味圧を線形補間する。
+SSD_API int32_t ssd_step_n_interp(SSDHandle* h, const double* p_knots, int32_t knots,
+                                  int32_t steps, double dt, SSDTelemetry* out,
+                                  int32_t telemetry_stride);
 SSD_API void ssd_get_params(SSDHandle* h, SSDParams* out);
-SSD_API void ssd_set_params(SSDHandle* h, const SSDParams* in);
+// 適用したら 1。疎グラフに eps_noise > 0 を渡したときと引数が不正なときは何も変えず 0
+SSD_API int32_t ssd_set_params(SSDHandle* h, const SSDParams* in);
+// 密行列ステップの作業スレッド数を変える（SSDCreateOptions::threads と同じ意味、疎グラフでは無視）。
+// 行列のページ配置は作成時のまま
+SSD_API void ssd_set_threads(SSDHandle* h, int32_t threads);
 SSD_API int32_t ssd_get_N(SSDHandle* h);
 SSD_API int32_t ssd_get_kappa_row(SSDHandle* h, int32_t row, double* out_buf, int32_t len);
+// テレメトリリング（SSDCreateOptions::telemetry_ring）から古い順に最大 max 件を out へ
+// 取り出し、件数を返す（リング無しは 0）。ステップを進めるスレッドとは別の1スレッドから
+// ロック無しで呼べる。リングが満杯の間のステップは記録されず、件数だけ数える
+SSD_API int32_t ssd_drain_telemetry(SSDHandle* h, SSDTelemetry* out, int32_t max);
+// 満杯で記録できなかったステップ数（累計）
+SSD_API uint64_t ssd_get_telemetry_dropped(SSDHandle* h);
+// kappa / w の行列ビュー。成功で 0、疎グラフ（行列を持たない）や不正な引数は -1
+SSD_API int32_t ssd_get_kappa_view(SSDHandle* h, SSDMatrixView* out);
+// w は触れた経路だけを持ち、初回の ssd_get_w_view で N*N の配列を作る（以後はそれを更新し続ける）
+SSD_API int32_t ssd_get_w_view(SSDHandle* h, SSDMatrixView* out);
+// kappa / w を書き換えるステップごとに1増える世代番号（手元の写しが古いかの判定用）
+SSD_API uint64_t ssd_get_generation(SSDHandle* h);
+// 作成時からのステップ数（状態の保存・復元で引き継がれる。ssd_replay の位置指定に使う）
+SSD_API uint64_t ssd_get_step(SSDHandle* h);
+// 現在の状態を O(1) で読む（ステップを進めず、乱数も消費しない）。不正な引数は -1
+SSD_API int32_t ssd_get_state(SSDHandle* h, SSDStateView* out);
+// kappa の真値の部分行列 [row0, row0+rows) x [col0, col0+cols) を out へ行優先で
+// （1行 cols 要素）書き出し、要素数を返す。範囲外・不正な引数は -1。疎グラフでも使える
+SSD_API int64_t ssd_copy_kappa_block(SSDHandle* h, int32_t row0, int32_t col0, int32_t rows,
+                                     int32_t cols, double* out);
+
+// 状態スナップショット（ssd_save_state / ssd_load_state の戻り値）
+enum {
+  SSD_STATE_OK = 0,
+  SSD_STATE_ERR_ARG = -1,       // 引数が不正
+  SSD_STATE_ERR_IO = -2,        // ファイルを開けない・読み書きに失敗
+  SSD_STATE_ERR_FORMAT = -3,    // 形式・版が違う、または内容が矛盾
+  SSD_STATE_ERR_CHECKSUM = -4,  // チェックサム不一致（破損）
+  SSD_STATE_ERR_ALLOC = -5,     // メモリ確保に失敗
+};
+// N・現在ノード・E/F/T・方策・パラメータ・乱数状態・kappa/w を版付きの小端順形式で保存する。
+// kappa / w は格納値の生配列を 64B 境界に置くので mmap してそのまま参照できる
+// （w は密な配列を作っていなければ触れた経路の一覧として保存する）
+SSD_API int32_t ssd_save_state(SSDHandle* h, const char* path);
+// 保存した状態から新しいハンドルを作る（失敗時 NULL、err に理由、err は NULL 可）。
+// 作業スレッド数は復元しない（読み込んだハンドルは 1、ssd_set_threads で変える）。保存元と同じ
+// スレッド数を設定して続ければ、以後のステップは保存元のハンドルで続けた場合とビット一致する
+SSD_API SSDHandle* ssd_load_state(const char* path, int32_t* err);
+// 再生ログの記録を始める。以後のステップ入力（p, dt）と ssd_set_params / ssd_set_threads を
+// path に追記し、checkpoint_interval ステップごと（0 なら開始時だけ）に状態を挟む。
+// 1ステップの記録は入力16バイトをまとめて書くだけ（チェックポイントは ssd_save_state 1回分）。
+// マッピング版（ssd_create_mapped）と記録中のハンドルは SSD_STATE_ERR_ARG
+SSD_API int32_t ssd_record_start(SSDHandle* h, const char* path, uint64_t checkpoint_interval);
+// 記録を終えてファイルを閉じる。記録中に書き出しに失敗していればそのエラー
+// （失敗以後は記録されていない）。ssd_destroy でも閉じる
+SSD_API int32_t ssd_record_stop(SSDHandle* h);
+// 記録の step ステップ目まで（ssd_get_step == step、直後の設定変更を含む）を直前の
+// チェックポイントから再計算した新しいハンドルを作る。記録元とビット一致する。
+// step が記録の範囲外なら NULL（err = SSD_STATE_ERR_ARG）
+SSD_API SSDHandle* ssd_replay(const char* path, uint64_t step, int32_t* err);
+
+// アンサンブル: M 個の N ノードグラフを1つの構造体配列で保持し、スレッドプールで一括ステップする。
+// メンバー m は ssd_create(N, params, ssd_ensemble_member_seed(seed, m)) と同じ軌道をたどる
+// （総和の丸め誤差を除く）。スレッド数は結果に影響しない。
+SSD_API SSDEnsemble* ssd_ensemble_create(int32_t M, int32_t N, const SSDParams* params, uint64_t seed);
+SSD_API void ssd_ensemble_destroy(SSDEnsemble* e);
+// p はメンバーごとの意味圧（M 要素）、out はメンバーごとのテレメトリ（M 要素、NULL 可）
+SSD_API void ssd_ensemble_step(SSDEnsemble* e, const double* p, double dt, SSDTelemetry* out);
+// 作業スレッド数（呼び出しスレッドを含む）。0 以下ならハードウェアスレッド数（作成時の既定）
+SSD_API void ssd_ensemble_set_threads(SSDEnsemble* e, int32_t threads);
+SSD_API int32_t ssd_ensemble_get_M(SSDEnsemble* e);
+SSD_API int32_t ssd_ensemble_get_kappa_row(SSDEnsemble* e, int32_t member, int32_t row,
+                                           double* out_buf, int32_t len);
+SSD_API uint64_t ssd_ensemble_member_seed(uint64_t seed, int32_t member);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,101 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// 経路添字 → 値 の開番地法ハッシュ表（非公開）
+//
+// 密行列の w は跳躍・ε探索で1経路ずつ足されるだけでステップからは読まれないため、
+// 触れた経路だけをここに持つ（密な配列はビューを求められたときに作る）。
+// 削除は無く、使用率が 1/2 を超えたら倍に広げる（確保は容量を超えたときだけ）。
+template <class V>
+class SSDEdgeMap {
+public:
+    static constexpr uint64_t kEmpty = ~(uint64_t)0;
+
+    size_t size() const { return count_; }
+
+    // edges 件を入れても広げずに済む表のバイト数
+    static size_t bytes_for(size_t edges) {
+        size_t slots = 16;
+        while (slots < 2 * edges) slots <<= 1;
+        return slots * sizeof(std::pair<uint64_t, V>);
+    }
+    // 次の1件の追加で表を広げるか
+    bool will_grow() const { return 2 * (count_ + 1) > slots_.size(); }
+
+    void reserve(size_t edges) {
+        while (2 * edges > slots_.size()) grow();
+    }
+
+    // key の値（無ければ init で追加）
+    V& at(uint64_t key, const V& init) {
+        if (2 * (count_ + 1) > slots_.size()) grow();
+        size_t i = probe(key);
+        if (slots_[i].first == kEmpty) {
+            slots_[i] = {key, init};
+            count_++;
+        }
+        return slots_[i].second;
+    }
+
+    const V* find(uint64_t key) const {
+        if (slots_.empty()) return nullptr;
+        size_t i = probe(key);
+        return slots_[i].first == kEmpty ? nullptr : &slots_[i].second;
+    }
+
+    // 添字昇順の (key, value) 列（保存用）
+    std::vector<std::pair<uint64_t, V>> sorted() const {
+        std::vector<std::pair<uint64_t, V>> out;
+        out.reserve(count_);
+        for (const auto& s : slots_) {
+            if (s.first != kEmpty) out.push_back(s);
+        }
+        std::sort(out.begin(), out.end(),
+            [](const std::pair<uint64_t, V>& a, const std::pair<uint64_t, V>& b) { return a.first < b.first; });
+        return out;
+    }
+
+    template <class Fn>
+    void for_each(Fn&& fn) const {
+        for (const auto& s : slots_) {
+            if (s.first != kEmpty) fn(s.first, s.second);
+        }
+    }
+
+    void clear() {
+        std::vector<std::pair<uint64_t, V>>().swap(slots_);
+        count_ = 0;
+    }
+
+private:
+    size_t probe(uint64_t key) const {
+        size_t mask = slots_.size() - 1;
+        size_t i = (size_t)(mix(key) & mask);
+        while (slots_[i].first != kEmpty && slots_[i].first != key) i = (i + 1) & mask;
+        return i;
+    }
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    void grow() {
+        std::vector<std::pair<uint64_t, V>> old;
+        old.swap(slots_);
+        slots_.assign(std::max<size_t>(16, old.size() * 2), {kEmpty, V()});
+        for (const auto& s : old) {
+            if (s.first != kEmpty) slots_[probe(s.first)] = s;
+        }
+    }
+
+    std::vector<std::pair<uint64_t, V>> slots_;  /* 容量は2の冪（空きは kEmpty） */
+    size_t count_ = 0;
+};
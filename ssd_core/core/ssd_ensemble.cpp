@@ -0,0 +1,209 @@
+﻿#include "ssd_ensemble.h"
+#include "ssd_step_impl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/* --- アンサンブルの1メンバーをグラフとして見せる（経路の間隔 M = SSDEnsemble::stride） --- */
+
+struct EnsembleMemberGraph {
+    int N;
+    size_t M;
+    double* kappa;  /* メンバー先頭（経路 e は kappa[e*M]） */
+    double* w;
+    const double* j;
+    EnsembleScratch* scratch;
+
+    void row_values(int row, double* out, int len) const {
+        const double* r = kappa + (size_t)row * N * M;
+        int m = std::min(N, len);
+        for (int k = 0; k < m; ++k) out[k] = r[(size_t)k * M];
+    }
+
+    void add_edge(int row, int col, double d_kappa, double d_w) {
+        size_t idx = ((size_t)row * N + col) * M;
+        w[idx] += d_w;
+        kappa[idx] += d_kappa;
+    }
+
+    void relax_top(size_t count, double eps, double kappa_min) {
+        // メンバーの j を連続配列に集めて密行列と同じ基数選択を使う
+        size_t total = (size_t)N * N;
+        double* jj = scratch->relax_j.data();
+        for (size_t i = 0; i < total; ++i) jj[i] = j[i * M];
+
+        RelaxCut cut = ssd_relax_threshold(jj, total, count, scratch->relax_hist.data());
+        ssd_relax_for_each(jj, 0, total, cut.key, cut.ties, [&](size_t i) {
+            double& k = kappa[i * M];
+            k = std::max(k - eps, kappa_min);
+        });
+    }
+
+    int argmax_row(int row) const {
+        const double* r = kappa + (size_t)row * N * M;
+        return ssd_argmax_pick(row, N, [&](int k) { return r[(size_t)k * M]; });
+    }
+};
+
+/* --- SSDEnsemble --- */
+
+SSDEnsemble::SSDEnsemble(int m, int n, const SSDParams& p, uint64_t seed)
+    : M(m), N(n), prm(p), stride(ssd_ensemble_stride(m)),
+      kappa((size_t)n * n * stride, 0.0), w((size_t)n * n * stride, 0.0),
+      j((size_t)n * n * stride, 0.0),
+      E(m, 0.0), F(m, 0.0), T(m, p.T0), current(m, 0),
+      pi((size_t)m * n, 1.0 / n), pi_sum(m, 1.0), logits((size_t)m * n, 0.0) {
+    H.assign(m, entropy_norm(pi.data(), n));
+    rng.reserve(m);
+    for (int i = 0; i < m; ++i) rng.emplace_back(SSD_RNG_MT19937, ssd_ensemble_member_seed(seed, i));
+    set_threads(0);
+}
+
+void SSDEnsemble::set_threads(int threads) {
+    // 失敗時に既存のプールを残すため、新しいプールとスクラッチを揃えてから差し替える
+    std::unique_ptr<SSDThreadPool> next(new SSDThreadPool(threads));
+    std::vector<EnsembleScratch> next_scratch(next->size());
+    for (EnsembleScratch& s : next_scratch) {
+        s.relax_j.assign((size_t)N * N, 0.0);
+        s.relax_hist.assign(SSD_RELAX_HIST_SIZE, 0);
+    }
+    pool = std::move(next);
+    scratch = std::move(next_scratch);
+}
+
+void SSDEnsemble::step(const double* p, double dt, SSDTelemetry* out) {
+    int blocks = (M + SSD_ENSEMBLE_BLOCK - 1) / SSD_ENSEMBLE_BLOCK;
+    // 捕捉は2つまで（std::function の内部バッファに収まり、呼ぶたびのヒープ確保が無い）
+    struct StepArgs {
+        const double* p;
+        double dt;
+        SSDTelemetry* out;
+    } args{p, dt, out};
+    pool->parallel_for((size_t)blocks, [this, &args](size_t b0, size_t b1, int worker) {
+        for (size_t b = b0; b < b1; ++b) {
+            int begin = (int)b * SSD_ENSEMBLE_BLOCK;
+            int end = std::min(M, begin + SSD_ENSEMBLE_BLOCK);
+            step_block(begin, end, args.p, args.dt, args.out, scratch[worker]);
+        }
+    });
+}
+
+// メンバー軸の AlignFlow + UpdateKappa。経路ごとに連続する count メンバーを
+// ssd_align_edge で更新する（要素ごとの演算はスカラーカーネルとビット一致）。
+// kNoise では j にメンバーごとのノイズが入っている
+template <bool kNoise>
+static void align_members(const AlignKernelArgs& a, double* kappa, double* j, size_t total,
+                          size_t stride, const double* p, int count, double* J_sq,
+                          double* kappa_sum) {
+    for (size_t e = 0; e < total; ++e) {
+        double* kr = kappa + e * stride;
+        double* jr = j + e * stride;
+        for (int i = 0; i < count; ++i) {
+            double nk = ssd_align_edge<kNoise>(a, p[i], kr[i], jr[i], jr + i);
+            J_sq[i] += jr[i] * jr[i];
+            kr[i] = nk;
+            kappa_sum[i] += nk;
+        }
+    }
+}
+
+void SSDEnsemble::step_block(int begin, int end, const double* p, double dt, SSDTelemetry* out,
+                             EnsembleScratch& s) {
+    size_t total = (size_t)N * N;
+    int count = end - begin;
+
+    // === 1+2. AlignFlow + UpdateKappa（メンバー軸でベクトル化） ===
+    // ノイズはメンバーごとに（各自の乱数列の鍵で）一括生成して j に置く
+    bool with_noise = prm.eps_noise > 0.0;
+    if (with_noise) {
+        for (int m = begin; m < end; ++m) {
+            rng[m].fill_edge_noise(j.data() + m, total, prm.eps_noise, stride);
+        }
+    }
+
+    // p はメンバーごとに align_members へ渡す
+    AlignKernelArgs args{prm.G0, prm.g, 0.0, prm.eta, prm.rho, prm.lam, prm.kappa_min, dt};
+    double* J_sq = s.J_sq;
+    double* kappa_sum = s.kappa_sum;
+    std::fill(J_sq, J_sq + count, 0.0);
+    std::fill(kappa_sum, kappa_sum + count, 0.0);
+
+    // ノイズの有無は呼び出しごとに一度だけ選ぶ
+    auto align = with_noise ? align_members<true> : align_members<false>;
+    align(args, kappa.data() + begin, j.data() + begin, total, stride, p + begin, count, J_sq,
+          kappa_sum);
+
+    // === 3〜6. メンバーごとの跳躍判定（ssd_step と共通） ===
+    for (int i = 0; i < count; ++i) {
+        int m = begin + i;
+        EnsembleMemberGraph graph{N, stride, kappa.data() + m, w.data() + m, j.data() + m, &s};
+        SSDStepState st{N, current[m], E[m], F[m], T[m], H[m], pi_sum[m], prm, rng[m],
+                        pi.data() + (size_t)m * N, logits.data() + (size_t)m * N};
+        AlignKernelResult fused{J_sq[i], kappa_sum[i], 0.0};
+        ssd_step_finish(&st, graph, fused, p[m], dt, out ? out + m : nullptr);
+        rng[m].step++;
+    }
+}
+
+/* --- API実装 --- */
+
+extern "C" uint64_t ssd_ensemble_member_seed(uint64_t seed, int32_t member) {
+    // splitmix64 でメンバーごとに独立なシードを導出（0 は ssd_create が置換するので避ける）
+    if (seed == 0) seed = 123456789ULL;
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL * ((uint64_t)member + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return z ? z : 123456789ULL;
+}
+
+extern "C" SSDEnsemble* ssd_ensemble_create(int32_t M, int32_t N, const SSDParams* params,
+                                            uint64_t seed) {
+    if (M <= 0 || N <= 0) return nullptr;
+
+    SSDParams p;
+    if (params) {
+        std::memcpy(&p, params, sizeof(SSDParams));
+    }
+
+    try {
+        return new SSDEnsemble(M, N, p, seed);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+extern "C" void ssd_ensemble_destroy(SSDEnsemble* e) {
+    delete e;
+}
+
+extern "C" void ssd_ensemble_set_threads(SSDEnsemble* e, int32_t threads) {
+    if (!e) return;
+
+    try {
+        e->set_threads(threads);
+    } catch (...) {
+        // スレッド生成に失敗したら現在のプールのまま続行
+    }
+}
+
+extern "C" int32_t ssd_ensemble_get_M(SSDEnsemble* e) {
+    return e ? e->M : 0;
+}
+
+extern "C" void ssd_ensemble_step(SSDEnsemble* e, const double* p, double dt, SSDTelemetry* out) {
+    if (!e || !p) return;
+    e->step(p, dt, out);
+}
+
+extern "C" int32_t ssd_ensemble_get_kappa_row(SSDEnsemble* e, int32_t member, int32_t row,
+                                              double* out_buf, int32_t len) {
+    if (!e || !out_buf || member < 0 || member >= e->M || row < 0 || row >= e->N) return 0;
+
+    int m = std::min(e->N, (int)len);
+    if (m <= 0) return 0;
+    const double* r = e->kappa.data() + (size_t)row * e->N * e->stride + member;
+    for (int k = 0; k < m; ++k) out_buf[k] = r[(size_t)k * e->stride];
+    return m;
+}
@@ -0,0 +1,91 @@
+﻿#pragma once
+#include "ssd_core.h"
+#include "ssd_random.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// SSDEnsemble 内部定義（非公開）
+//
+// M 個の小さな密グラフを1つの構造体配列（SoA）で持つ。経路ごとの配列は
+// [N*N][stride]（経路優先・メンバー連続、stride は M をキャッシュ行の double 数に切り上げ、
+// 余りの枠は使わない）で、AlignFlow + UpdateKappa はメンバー軸に連続アクセスしてベクトル化する。
+// 各経路のメンバー列はキャッシュ行頭から始まるので、64 メンバーの区間が行をまたがない。各メンバーは ssd_create(N, params,
+// ssd_ensemble_member_seed(seed, m)) のハンドルと同じ乱数列・同じ手順で進む。
+
+// 整合更新を1度に回すメンバー数（総和スクラッチの大きさ）
+constexpr int SSD_ENSEMBLE_BLOCK = 64;
+
+// 経路ごとのメンバー列の境界（バイト、キャッシュ行）
+constexpr size_t SSD_ENSEMBLE_ALIGN = 64;
+
+// 経路あたりのメンバー枠（M を SSD_ENSEMBLE_ALIGN に収まる double 数の倍数に切り上げ）
+inline size_t ssd_ensemble_stride(int m) {
+    const size_t lanes = SSD_ENSEMBLE_ALIGN / sizeof(double);
+    return ((size_t)m + lanes - 1) / lanes * lanes;
+}
+
+// 先頭を SSD_ENSEMBLE_ALIGN 境界に置く std::vector 用アロケータ
+template <class T>
+struct EnsembleAllocator {
+    using value_type = T;
+
+    EnsembleAllocator() = default;
+    template <class U>
+    EnsembleAllocator(const EnsembleAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(SSD_ENSEMBLE_ALIGN)));
+    }
+    void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(SSD_ENSEMBLE_ALIGN)); }
+
+    template <class U>
+    bool operator==(const EnsembleAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const EnsembleAllocator<U>&) const { return false; }
+};
+
+using EnsembleArray = std::vector<double, EnsembleAllocator<double>>;
+
+// 作業者ごとのスクラッチ
+struct EnsembleScratch {
+    std::vector<double> relax_j;      /* N*N RelaxTop 用 j（1メンバー分を集約） */
+    std::vector<uint64_t> relax_hist;
+    double J_sq[SSD_ENSEMBLE_BLOCK];
+    double kappa_sum[SSD_ENSEMBLE_BLOCK];
+};
+
+struct SSDEnsemble {
+    int M;
+    int N;
+    SSDParams prm;
+    size_t stride;  /* 経路あたりのメンバー枠（ssd_ensemble_stride(M)） */
+
+    EnsembleArray kappa;  /* [N*N][stride] */
+    EnsembleArray w;      /* [N*N][stride] */
+    EnsembleArray j;      /* [N*N][stride] 整合流スクラッチ */
+
+    std::vector<double> E, F, T;  /* [M] */
+    std::vector<double> H;        /* [M] pi の正規化エントロピー（キャッシュ） */
+    std::vector<int> current;     /* [M] */
+    std::vector<double> pi;       /* [M][N] 跳躍方策の未正規化重み */
+    std::vector<double> pi_sum;   /* [M] */
+    std::vector<double> logits;   /* [M][N] スクラッチ */
+
+    std::vector<SSDRandom> rng;  /* [M] */
+
+    std::unique_ptr<SSDThreadPool> pool;
+    std::vector<EnsembleScratch> scratch;  /* 作業者ごと */
+
+    SSDEnsemble(int m, int n, const SSDParams& p, uint64_t seed);
+
+    void set_threads(int threads);
+    void step(const double* p, double dt, SSDTelemetry* out);
+
+private:
+    void step_block(int begin, int end, const double* p, double dt, SSDTelemetry* out,
+                    EnsembleScratch& s);
+};
@@ -0,0 +1,193 @@
+﻿#pragma once
+#include "ssd_core.h"
+#include "ssd_edge_map.h"
+#include "ssd_kernels.h"
+#include "ssd_mapped.h"
+#include "ssd_random.h"
+#include "ssd_replay.h"
+#include "ssd_sparse.h"
+#include "ssd_telemetry_ring.h"
+#include "thread_pool.h"
+
+#include <vector>
+#include <random>
+#include <memory>
+#include <algorithm>
+
+// SSDHandle 内部定義（非公開）
+
+// 密行列グラフ（ssd_create）。S は kappa / w の格納型（double / float / SSDbf16）
+//
+// 静穏ステップ（eps_noise=0 かつ j^2 項が消える eta*rho*g*p=0 の場合）では
+// UpdateKappa は全経路に同じアフィン写像 kappa ← m*kappa + c を掛けるだけなので、
+// 真値を scale*kappa[i] + offset として写像の合成だけを O(1) で行う（遅延アフィン変換）。
+// kappa_min でのクリップは、真値の下界 lo について m*lo + c >= kappa_min が
+// 成り立つ（＝どの経路でもクリップが発動しない）場合に限り遅延させ、
+// そうでなければ写像を畳み込んで通常の融合カーネルで更新する。
+//
+// ssd_create_mapped では kappa / w / j をファイルのマッピング上に置き
+// （[kappa][w][j]、各領域はページ境界）、通常ステップを行ブロックごとに処理して
+// 次のブロックを先読みさせる。
+//
+// スレッドプールがあれば（SSDCreateOptions::threads）全経路を走査する処理を行ブロックに分けて
+// 作業スレッドで分担する。ブロック分割は N と格納型だけで決め、総和はブロックごとの部分和を
+// ブロック順に足すので、結果はスレッド数に依らない（単一スレッドとは総和の丸め誤差を除いて一致）。
+// 各ブロックは毎回同じスレッドが担当するため、作成時にそのスレッドから最初に書き込んで
+// ページをそのスレッドの NUMA ノードに置く（first touch）。
+template <class S>
+struct DenseGraphT {
+    using Traits = SSDStorageTraits<S>;
+    using J = typename Traits::compute;  /* 整合流の型（double / float） */
+
+    int N;
+    std::unique_ptr<SSDMappedFile> backing;  /* ssd_create_mapped のみ（他は nullptr） */
+    SSDBuffer<S> kappa; /* N*N 格納値（真値 = scale*kappa + offset） */
+    // w はステップから読まれないので、触れた経路だけを w_edges に持つ。
+    // 密な w はビュー（w_dense）を求められたとき・マッピング時だけ存在し、以後は w_edges は空
+    SSDBuffer<S> w;          /* N*N（未作成なら空） */
+    SSDEdgeMap<S> w_edges;   /* 経路添字 → 格納値（w が空の間だけ使う） */
+
+    // ステップ用スクラッチ（作成時に確保し毎tick再利用、定常状態でヒープ確保ゼロ）
+    SSDBuffer<J> j;                   /* N*N 整合流 */
+    std::vector<uint64_t> relax_hist; /* RelaxTop 基数選択ヒストグラム */
+
+    // 融合カーネル（作成時にCPU判定で選択）。添字はノイズの有無で、
+    // eps_noise の変更（ssd_set_params）にも選び直しなしで追従する
+    SSDAlignKernel<S> align_kernel[2];
+    uint32_t step_count;  /* bf16 確率的丸めの dither 用 */
+
+    // 遅延アフィン変換
+    double scale, offset;  /* 真値 = scale*格納値 + offset（scale > 0） */
+    double sum_s, sum_s2;  /* 格納値の Σ, Σ^2（接触経路ごとに差分で更新） */
+    double lo;             /* 真値の下界 */
+    uint32_t lazy_steps;   /* 直近の厳密な再集計からの遅延ステップ数 */
+
+    // 遅延ステップでは j も未展開: j[i] = j_scale*格納値 + j_offset。
+    // 展開前に再配線された経路は更新前の j を j_pending に退避する
+    bool j_stale;
+    double j_scale, j_offset;
+    std::vector<std::pair<size_t, double>> j_pending;
+
+    // 行ごとの argmax キャッシュ（ssd_argmax_floor の規則で選んだ列、真値で比較）。
+    // 同着の幅は真値の大きさと差で決まり、遅延ステップの写像でも変わるので、
+    // 真値を動かすステップ・畳み込み・RelaxTop で世代を進めて一括無効化し、
+    // add_edge では触れた行だけを無効化する
+    mutable std::vector<int32_t> row_best;   /* N */
+    mutable std::vector<uint32_t> row_epoch; /* N（== best_epoch なら row_best が有効） */
+    uint32_t best_epoch;
+
+    // 行ブロック処理（マッピング時・並列時）
+    struct BlockPartial {
+        AlignKernelResult sums;  /* ブロック内の部分和 */
+        double lo;               /* RelaxTop 後のブロック内最小値 */
+        uint64_t ties;           /* RelaxTop の同値の件数・割り当て */
+    };
+    size_t block_rows;                  /* 1ブロックの行数 */
+    SSDThreadPool* pool;                /* 並列時のみ（SSDHandle が所有） */
+    std::vector<BlockPartial> partials; /* ブロックごとの部分和 */
+    std::vector<uint64_t> worker_hist;  /* 作業者数 × SSD_RELAX_HIST_SIZE */
+
+    // ssd_create_mapped のファイルサイズ
+    static size_t mapped_bytes(int n) {
+        size_t total = (size_t)n * n;
+        return 2 * ssd_mapped_round_up(total * sizeof(S)) + ssd_mapped_round_up(total * sizeof(J));
+    }
+
+    // file は mapped_bytes(n) バイト（中身はゼロ = 全経路 0）。pool があれば並列に処理する
+    explicit DenseGraphT(int n, std::unique_ptr<SSDMappedFile> file = nullptr,
+                         SSDThreadPool* pool = nullptr);
+
+    DenseGraphT()
+        : N(0), align_kernel{nullptr, nullptr}, step_count(0), scale(1.0), offset(0.0), sum_s(0.0),
+          sum_s2(0.0), lo(0.0), lazy_steps(0), j_stale(false), j_scale(0.0), j_offset(0.0),
+          best_epoch(1), block_rows(0), pool(nullptr) {}
+
+    AlignKernelResult align_update(SSDHandle& h, double p, double dt);
+    void row_values(int row, double* out, int len) const;
+    void copy_block(int row0, int col0, int nrows, int ncols, double* out) const;
+    void add_edge(int row, int col, double d_kappa, double d_w);
+    void relax_top(size_t count, double eps, double kappa_min);
+    int argmax_row(int row) const;
+
+    // w の経路 i の格納値
+    S w_at(size_t i) const {
+        if (w.size()) return w[i];
+        const S* v = w_edges.find(i);
+        return v ? *v : Traits::store(0.0f, 0);
+    }
+    // 密な w を作って返す（以後の更新は密な w に書く）
+    SSDBuffer<S>& w_dense();
+
+    // 作業スレッドを差し替える（nullptr で単一スレッド）。ページの配置はやり直さない
+    void set_pool(SSDThreadPool* p);
+
+    // 真値（変換適用後）
+    double kappa_at(size_t i) const { return scale * (double)Traits::load(kappa[i]) + offset; }
+
+private:
+    AlignKernelResult align_blocked(SSDHandle& h, const AlignKernelArgs& args, bool noisy);
+    void expand_j();
+    void fold_transform();
+    void resum();
+    void invalidate_rows();
+
+    size_t block_count() const;
+    BlockPartial* block_partials();
+    // ブロック b の経路 [begin, end) について fn(b, begin, end, worker)（並列時は作業スレッドで）
+    template <class Fn>
+    void for_each_block(Fn&& fn);
+};
+
+using DenseGraph = DenseGraphT<double>;
+
+struct SSDHandle {
+    int N;
+    int current;
+    double E, F, T;
+    std::vector<double> pi;    /* size N 跳躍方策の未正規化重み（確率は pi[k] / pi_sum） */
+    double pi_sum;
+    double H;                  /* pi の正規化エントロピー（pi を書き換えたときだけ再計算、作成時に初期化） */
+    double kappa_mean;         /* 直近のステップの kappa 平均（ssd_get_state） */
+    SSDParams prm;
+    SSDRandom rng;
+    uint64_t generation;       /* kappa / w を書き換えるステップごとに1増える（行列ビューの世代） */
+
+    std::vector<double> logits;  /* size N 跳躍ロジット（スクラッチ） */
+    std::unique_ptr<SSDTelemetryRing> ring;  /* テレメトリリング（無効なら nullptr） */
+    std::unique_ptr<SSDThreadPool> pool;     /* 密行列ステップの作業スレッド（単一スレッドなら nullptr） */
+    std::unique_ptr<SSDRecorder> recorder;   /* 再生ログの記録中のみ（ssd_record_start） */
+
+    // グラフ表現はいずれか1つだけが有効（ssd_visit_graph で振り分ける）
+    DenseGraph dense;                     /* 密行列 double（他の表現では空） */
+    std::unique_ptr<DenseGraphT<float>> dense_f32;     /* SSD_STORAGE_F32 */
+    std::unique_ptr<DenseGraphT<SSDbf16>> dense_bf16;  /* SSD_STORAGE_BF16 */
+    std::unique_ptr<SparseGraph> sparse;  /* 疎バックエンド（ssd_create_sparse） */
+
+    // backing があれば密行列をそのマッピング上に置く（ssd_create_mapped、疎グラフ不可）
+    SSDHandle(int n, const SSDParams& p, uint64_t seed, const SSDCreateOptions& opts,
+              std::unique_ptr<SSDMappedFile> backing = nullptr)
+        : N(n), current(0), E(0.0), F(0.0), T(p.T0), pi(n, 1.0 / std::max(1,n)), pi_sum(1.0), H(1.0), kappa_mean(0.0),
+          prm(p), rng(opts.rng, seed), generation(0),
+          logits(n, 0.0),
+          pool(opts.sparse || opts.threads == 1 ? nullptr : new SSDThreadPool(opts.threads)),
+          dense(opts.sparse || opts.storage != SSD_STORAGE_F64 ? DenseGraph()
+                : DenseGraph(n, std::move(backing), pool.get())) {
+        if (opts.telemetry_ring > 0) ring.reset(new SSDTelemetryRing((size_t)opts.telemetry_ring));
+        if (opts.sparse) {
+            sparse.reset(new SparseGraph(n));
+        } else if (opts.storage == SSD_STORAGE_F32) {
+            dense_f32.reset(new DenseGraphT<float>(n, std::move(backing), pool.get()));
+        } else if (opts.storage == SSD_STORAGE_BF16) {
+            dense_bf16.reset(new DenseGraphT<SSDbf16>(n, std::move(backing), pool.get()));
+        }
+    }
+};
+
+// 有効なグラフ表現で fn(graph) を呼ぶ
+template <class Fn>
+auto ssd_visit_graph(SSDHandle* h, Fn&& fn) -> decltype(fn(h->dense)) {
+    if (h->sparse) return fn(*h->sparse);
+    if (h->dense_f32) return fn(*h->dense_f32);
+    if (h->dense_bf16) return fn(*h->dense_bf16);
+    return fn(h->dense);
+}
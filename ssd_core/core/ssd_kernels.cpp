@@ -0,0 +1,447 @@
+﻿#include "ssd_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define SSD_KERNELS_X86 1
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+    #define SSD_TARGET_AVX2
+    #define SSD_TARGET_AVX512
+  #else
+    #define SSD_TARGET_AVX2 __attribute__((target("avx2")))
+    #define SSD_TARGET_AVX512 __attribute__((target("avx512f")))
+  #endif
+#else
+  #define SSD_KERNELS_X86 0
+#endif
+
+/* --- スカラー実装（フォールバック兼 端数処理） --- */
+
+template <bool kNoise>
+static inline void align_scalar_range(const AlignKernelArgs& a, double* kappa, double* j,
+                                      const double* noise, size_t begin, size_t end,
+                                      AlignKernelResult& r) {
+    for (size_t i = begin; i < end; ++i) {
+        double new_kappa = ssd_align_edge<kNoise>(a, a.p, kappa[i], kNoise ? noise[i] : 0.0, j + i);
+        r.J_sq += j[i] * j[i];
+        kappa[i] = new_kappa;
+        r.kappa_sum += new_kappa;
+        r.kappa_sq_sum += new_kappa * new_kappa;
+    }
+}
+
+template <bool kNoise>
+static AlignKernelResult align_scalar(const AlignKernelArgs& a, double* kappa, double* j,
+                                      const double* noise, size_t n) {
+    AlignKernelResult r{0.0, 0.0, 0.0};
+    align_scalar_range<kNoise>(a, kappa, j, noise, 0, n, r);
+    return r;
+}
+
+#if SSD_KERNELS_X86
+
+/* --- AVX2 実装（4レーン） --- */
+// FMAは使わない：要素ごとの演算順序をスカラー版と揃え、kappa更新をビット一致させる
+
+template <bool kNoise>
+SSD_TARGET_AVX2
+static AlignKernelResult align_avx2(const AlignKernelArgs& a, double* kappa, double* j,
+                                    const double* noise, size_t n) {
+    const __m256d G0 = _mm256_set1_pd(a.G0);
+    const __m256d g = _mm256_set1_pd(a.g);
+    const __m256d p = _mm256_set1_pd(a.p);
+    const __m256d eta = _mm256_set1_pd(a.eta);
+    const __m256d rho = _mm256_set1_pd(a.rho);
+    const __m256d lam = _mm256_set1_pd(a.lam);
+    const __m256d kmin = _mm256_set1_pd(a.kappa_min);
+    const __m256d dt = _mm256_set1_pd(a.dt);
+
+    __m256d jsq = _mm256_setzero_pd();
+    __m256d ksum = _mm256_setzero_pd();
+    __m256d ksq = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d k = _mm256_loadu_pd(kappa + i);
+        __m256d val = _mm256_mul_pd(_mm256_add_pd(G0, _mm256_mul_pd(g, k)), p);
+        if (kNoise) val = _mm256_add_pd(val, _mm256_loadu_pd(noise + i));
+        _mm256_storeu_pd(j + i, val);
+        jsq = _mm256_add_pd(jsq, _mm256_mul_pd(val, val));
+
+        __m256d work = _mm256_sub_pd(_mm256_mul_pd(p, val),
+                                     _mm256_mul_pd(_mm256_mul_pd(rho, val), val));
+        __m256d gain = _mm256_mul_pd(eta, work);
+        __m256d decay = _mm256_mul_pd(lam, _mm256_sub_pd(k, kmin));
+        __m256d nk = _mm256_add_pd(k, _mm256_mul_pd(_mm256_sub_pd(gain, decay), dt));
+        nk = _mm256_max_pd(nk, kmin);
+        _mm256_storeu_pd(kappa + i, nk);
+        ksum = _mm256_add_pd(ksum, nk);
+        ksq = _mm256_add_pd(ksq, _mm256_mul_pd(nk, nk));
+    }
+
+    alignas(32) double lanes_j[4], lanes_k[4], lanes_q[4];
+    _mm256_store_pd(lanes_j, jsq);
+    _mm256_store_pd(lanes_k, ksum);
+    _mm256_store_pd(lanes_q, ksq);
+    AlignKernelResult r{(lanes_j[0] + lanes_j[1]) + (lanes_j[2] + lanes_j[3]),
+                        (lanes_k[0] + lanes_k[1]) + (lanes_k[2] + lanes_k[3]),
+                        (lanes_q[0] + lanes_q[1]) + (lanes_q[2] + lanes_q[3])};
+    align_scalar_range<kNoise>(a, kappa, j, noise, i, n, r);
+    return r;
+}
+
+/* --- AVX-512 実装（8レーン） --- */
+
+template <bool kNoise>
+SSD_TARGET_AVX512
+static AlignKernelResult align_avx512(const AlignKernelArgs& a, double* kappa, double* j,
+                                      const double* noise, size_t n) {
+    const __m512d G0 = _mm512_set1_pd(a.G0);
+    const __m512d g = _mm512_set1_pd(a.g);
+    const __m512d p = _mm512_set1_pd(a.p);
+    const __m512d eta = _mm512_set1_pd(a.eta);
+    const __m512d rho = _mm512_set1_pd(a.rho);
+    const __m512d lam = _mm512_set1_pd(a.lam);
+    const __m512d kmin = _mm512_set1_pd(a.kappa_min);
+    const __m512d dt = _mm512_set1_pd(a.dt);
+
+    __m512d jsq = _mm512_setzero_pd();
+    __m512d ksum = _mm512_setzero_pd();
+    __m512d ksq = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d k = _mm512_loadu_pd(kappa + i);
+        __m512d val = _mm512_mul_pd(_mm512_add_pd(G0, _mm512_mul_pd(g, k)), p);
+        if (kNoise) val = _mm512_add_pd(val, _mm512_loadu_pd(noise + i));
+        _mm512_storeu_pd(j + i, val);
+        jsq = _mm512_add_pd(jsq, _mm512_mul_pd(val, val));
+
+        __m512d work = _mm512_sub_pd(_mm512_mul_pd(p, val),
+                                     _mm512_mul_pd(_mm512_mul_pd(rho, val), val));
+        __m512d gain = _mm512_mul_pd(eta, work);
+        __m512d decay = _mm512_mul_pd(lam, _mm512_sub_pd(k, kmin));
+        __m512d nk = _mm512_add_pd(k, _mm512_mul_pd(_mm512_sub_pd(gain, decay), dt));
+        nk = _mm512_max_pd(nk, kmin);
+        _mm512_storeu_pd(kappa + i, nk);
+        ksum = _mm512_add_pd(ksum, nk);
+        ksq = _mm512_add_pd(ksq, _mm512_mul_pd(nk, nk));
+    }
+
+    alignas(64) double lanes_j[8], lanes_k[8], lanes_q[8];
+    _mm512_store_pd(lanes_j, jsq);
+    _mm512_store_pd(lanes_k, ksum);
+    _mm512_store_pd(lanes_q, ksq);
+    AlignKernelResult r{0.0, 0.0, 0.0};
+    for (int l = 0; l < 8; ++l) {
+        r.J_sq += lanes_j[l];
+        r.kappa_sum += lanes_k[l];
+        r.kappa_sq_sum += lanes_q[l];
+    }
+    align_scalar_range<kNoise>(a, kappa, j, noise, i, n, r);
+    return r;
+}
+
+/* --- CPU判定 --- */
+
+static bool cpu_has_avx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool cpu_has_avx512f() {
+#ifdef _MSC_VER
+    if (!cpu_has_avx2()) return false;
+    if ((_xgetbv(0) & 0xE6) != 0xE6) return false;
+    int info[4];
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 16)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+#endif
+}
+
+#endif /* SSD_KERNELS_X86 */
+
+bool ssd_cpu_has_avx2() {
+#if SSD_KERNELS_X86
+    return cpu_has_avx2();
+#else
+    return false;
+#endif
+}
+
+bool ssd_cpu_has_avx512f() {
+#if SSD_KERNELS_X86
+    return cpu_has_avx512f();
+#else
+    return false;
+#endif
+}
+
+/* --- 格納型テンプレート版 --- */
+
+// 添字とステップから確率的丸め用の16bit値を作る（乱数列は消費しない）
+static inline uint32_t dither_hash(uint32_t i, uint32_t step) {
+    uint32_t x = i * 0x9E3779B1u ^ step * 0x85EBCA77u;
+    x ^= x >> 15;
+    x *= 0x2C1B3C6Du;
+    x ^= x >> 12;
+    return x;
+}
+
+// 汎用版。8要素ずつレーン別に総和を取り、内側ループをコンパイラにベクトル化させる
+// （総和の順序を固定するので -ffast-math なしで SIMD 化できる）。
+// base は先頭要素の絶対添字（dither 用）
+template <class S, bool kNoise>
+static inline AlignKernelResult align_t_body(const AlignKernelArgs& a, S* kappa, float* j,
+                                             const float* noise, size_t n, uint32_t step,
+                                             size_t base = 0) {
+    using Traits = SSDStorageTraits<S>;
+    const float G0 = (float)a.G0, g = (float)a.g, p = (float)a.p;
+    const float eta = (float)a.eta, rho = (float)a.rho, lam = (float)a.lam;
+    const float kmin = (float)a.kappa_min, dt = (float)a.dt;
+
+    constexpr size_t L = 8;
+    double jsq[L] = {}, ksum[L] = {}, ksq[L] = {};
+    auto element = [&](size_t i, size_t l) {
+        float k = Traits::load(kappa[i]);
+        float val = (G0 + g * k) * p;
+        if (kNoise) val += noise[i];
+        j[i] = val;
+        jsq[l] += (double)val * val;
+
+        float gain = eta * (p * val - rho * val * val);
+        float decay = lam * (k - kmin);
+        float nk = std::max(k + (gain - decay) * dt, kmin);
+        S stored = Traits::store(nk, dither_hash((uint32_t)(base + i), step));
+        kappa[i] = stored;
+
+        // 総和は格納後の値で取る（遅延アフィン更新の総和と整合させる）
+        double sk = Traits::load(stored);
+        ksum[l] += sk;
+        ksq[l] += sk * sk;
+    };
+
+    size_t i = 0;
+    for (; i + L <= n; i += L) {
+        for (size_t l = 0; l < L; ++l) element(i + l, l);
+    }
+    for (size_t l = 0; i < n; ++i, ++l) element(i, l);
+
+    AlignKernelResult r{0.0, 0.0, 0.0};
+    for (size_t l = 0; l < L; ++l) {
+        r.J_sq += jsq[l];
+        r.kappa_sum += ksum[l];
+        r.kappa_sq_sum += ksq[l];
+    }
+    return r;
+}
+
+#if SSD_KERNELS_X86
+// AVX2: 8 float レーン。総和は double 2本（下位/上位4レーン）に積む
+
+SSD_TARGET_AVX2
+static inline __m256 load8(const float* p) { return _mm256_loadu_ps(p); }
+
+SSD_TARGET_AVX2
+static inline __m256 load8(const SSDbf16* p) {
+    __m256i u = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(u, 16));
+}
+
+// 格納して、格納後の値（float）を返す
+SSD_TARGET_AVX2
+static inline __m256 store8(float* p, __m256 v, __m256i) {
+    _mm256_storeu_ps(p, v);
+    return v;
+}
+
+SSD_TARGET_AVX2
+static inline __m256 store8(SSDbf16* p, __m256 v, __m256i dither) {
+    __m256i u = _mm256_add_epi32(_mm256_castps_si256(v),
+                                 _mm256_and_si256(dither, _mm256_set1_epi32(0xFFFF)));
+    __m256i hi = _mm256_srli_epi32(u, 16);
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(hi, hi), 0x08);
+    _mm_storeu_si128((__m128i*)p, _mm256_castsi256_si128(packed));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(hi, 16));
+}
+
+// dither_hash の8レーン版
+SSD_TARGET_AVX2
+static inline __m256i dither8(size_t i, uint32_t step) {
+    __m256i idx = _mm256_add_epi32(_mm256_set1_epi32((int)(uint32_t)i),
+                                   _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i x = _mm256_xor_si256(_mm256_mullo_epi32(idx, _mm256_set1_epi32((int)0x9E3779B1u)),
+                                 _mm256_set1_epi32((int)(step * 0x85EBCA77u)));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x2C1B3C6D));
+    return _mm256_xor_si256(x, _mm256_srli_epi32(x, 12));
+}
+
+SSD_TARGET_AVX2
+static inline __m256d sq_add(__m256d acc, __m128 half) {
+    __m256d d = _mm256_cvtps_pd(half);
+    return _mm256_add_pd(acc, _mm256_mul_pd(d, d));
+}
+
+template <class S, bool kNoise>
+SSD_TARGET_AVX2
+static AlignKernelResult align_t_avx2_impl(const AlignKernelArgs& a, S* kappa, float* j,
+                                           const float* noise, size_t n, uint32_t step,
+                                           size_t base) {
+    const __m256 G0 = _mm256_set1_ps((float)a.G0);
+    const __m256 g = _mm256_set1_ps((float)a.g);
+    const __m256 p = _mm256_set1_ps((float)a.p);
+    const __m256 eta = _mm256_set1_ps((float)a.eta);
+    const __m256 rho = _mm256_set1_ps((float)a.rho);
+    const __m256 lam = _mm256_set1_ps((float)a.lam);
+    const __m256 kmin = _mm256_set1_ps((float)a.kappa_min);
+    const __m256 dt = _mm256_set1_ps((float)a.dt);
+
+    __m256d jsq = _mm256_setzero_pd(), ksum = _mm256_setzero_pd(), ksq = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 k = load8(kappa + i);
+        __m256 val = _mm256_mul_ps(_mm256_add_ps(G0, _mm256_mul_ps(g, k)), p);
+        if (kNoise) val = _mm256_add_ps(val, _mm256_loadu_ps(noise + i));
+        _mm256_storeu_ps(j + i, val);
+        jsq = sq_add(sq_add(jsq, _mm256_castps256_ps128(val)), _mm256_extractf128_ps(val, 1));
+
+        __m256 work = _mm256_sub_ps(_mm256_mul_ps(p, val),
+                                    _mm256_mul_ps(_mm256_mul_ps(rho, val), val));
+        __m256 gain = _mm256_mul_ps(eta, work);
+        __m256 decay = _mm256_mul_ps(lam, _mm256_sub_ps(k, kmin));
+        __m256 nk = _mm256_add_ps(k, _mm256_mul_ps(_mm256_sub_ps(gain, decay), dt));
+        nk = _mm256_max_ps(nk, kmin);
+        __m256 sk = store8(kappa + i, nk, dither8(base + i, step));
+
+        __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(sk));
+        __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(sk, 1));
+        ksum = _mm256_add_pd(ksum, _mm256_add_pd(lo, hi));
+        ksq = _mm256_add_pd(ksq, _mm256_add_pd(_mm256_mul_pd(lo, lo), _mm256_mul_pd(hi, hi)));
+    }
+
+    alignas(32) double lanes_j[4], lanes_k[4], lanes_q[4];
+    _mm256_store_pd(lanes_j, jsq);
+    _mm256_store_pd(lanes_k, ksum);
+    _mm256_store_pd(lanes_q, ksq);
+    AlignKernelResult r{(lanes_j[0] + lanes_j[1]) + (lanes_j[2] + lanes_j[3]),
+                        (lanes_k[0] + lanes_k[1]) + (lanes_k[2] + lanes_k[3]),
+                        (lanes_q[0] + lanes_q[1]) + (lanes_q[2] + lanes_q[3])};
+
+    // 端数は汎用版で処理（dither は絶対添字から作るので同じ値になる）
+    if (i < n) {
+        AlignKernelResult t = align_t_body<S, kNoise>(a, kappa + i, j + i, kNoise ? noise + i : nullptr,
+                                                      n - i, step, base + i);
+        r.J_sq += t.J_sq;
+        r.kappa_sum += t.kappa_sum;
+        r.kappa_sq_sum += t.kappa_sq_sum;
+    }
+    return r;
+}
+
+#endif
+
+/* --- ノイズ有無で特殊化した実装の選択 --- */
+
+// double 版を共通の呼び出し形に合わせる（step / base は使わない）
+template <AlignKernelResult (*Fn)(const AlignKernelArgs&, double*, double*, const double*, size_t)>
+static AlignKernelResult align_f64(const AlignKernelArgs& a, double* kappa, double* j,
+                                   const double* noise, size_t n, uint32_t, size_t) {
+    return Fn(a, kappa, j, noise, n);
+}
+
+template <>
+SSDAlignKernel<double> ssd_align_kernel_by_name<double>(const char* name, bool noise) {
+    if (!name) return nullptr;
+    if (std::strcmp(name, "scalar") == 0) {
+        return noise ? align_f64<align_scalar<true>> : align_f64<align_scalar<false>>;
+    }
+#if SSD_KERNELS_X86
+    if (std::strcmp(name, "avx2") == 0 && cpu_has_avx2()) {
+        return noise ? align_f64<align_avx2<true>> : align_f64<align_avx2<false>>;
+    }
+    if (std::strcmp(name, "avx512") == 0 && cpu_has_avx512f()) {
+        return noise ? align_f64<align_avx512<true>> : align_f64<align_avx512<false>>;
+    }
+#endif
+    return nullptr;
+}
+
+// float / bf16 は AVX2 と汎用版（コンパイラのベクトル化）だけ
+template <class S>
+SSDAlignKernel<S> ssd_align_kernel_by_name(const char* name, bool noise) {
+    if (!name) return nullptr;
+    if (std::strcmp(name, "scalar") == 0) return noise ? align_t_body<S, true> : align_t_body<S, false>;
+#if SSD_KERNELS_X86
+    if (std::strcmp(name, "avx2") == 0 && cpu_has_avx2()) {
+        return noise ? align_t_avx2_impl<S, true> : align_t_avx2_impl<S, false>;
+    }
+#endif
+    return nullptr;
+}
+
+// CPU が対応する最も広い実装（初回のみ判定）
+template <class S>
+const char* ssd_align_kernel_name() {
+    static const char* const chosen = []() -> const char* {
+        for (const char* name : {"avx512", "avx2"}) {
+            if (ssd_align_kernel_by_name<S>(name, false)) return name;
+        }
+        return "scalar";
+    }();
+    return chosen;
+}
+
+template <class S>
+SSDAlignKernel<S> ssd_select_align_kernel_t(bool noise) {
+    return ssd_align_kernel_by_name<S>(ssd_align_kernel_name<S>(), noise);
+}
+
+#define SSD_ALIGN_KERNEL_INSTANTIATE(S)                                       \
+    template SSDAlignKernel<S> ssd_align_kernel_by_name<S>(const char*, bool); \
+    template const char* ssd_align_kernel_name<S>();                           \
+    template SSDAlignKernel<S> ssd_select_align_kernel_t<S>(bool);
+
+SSD_ALIGN_KERNEL_INSTANTIATE(double)
+SSD_ALIGN_KERNEL_INSTANTIATE(float)
+SSD_ALIGN_KERNEL_INSTANTIATE(SSDbf16)
+
+/* --- RelaxTop 閾値選択 --- */
+
+template <class T>
+static RelaxCut relax_threshold(const T* j, size_t n, size_t count, uint64_t* hist) {
+    return ssd_relax_select(count, hist, [=](uint64_t prefix, uint64_t mask, int shift,
+                                             uint64_t digit_mask, uint64_t* h) {
+        ssd_relax_count_digits(j, n, prefix, mask, shift, digit_mask, h);
+    });
+}
+
+RelaxCut ssd_relax_threshold(const double* j, size_t n, size_t count, uint64_t* hist) {
+    return relax_threshold(j, n, count, hist);
+}
+
+// float は double に変換したキーで選ぶ（変換は厳密で順序を保つ）
+RelaxCut ssd_relax_threshold(const float* j, size_t n, size_t count, uint64_t* hist) {
+    return relax_threshold(j, n, count, hist);
+}
+
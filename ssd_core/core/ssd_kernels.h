@@ -0,0 +1,238 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+// ssd_step 内部カーネル（非公開）
+// AlignFlow + UpdateKappa + kappa総和 を1回のメモリパスで処理する
+
+struct AlignKernelArgs {
+  double G0;
+  double g;
+  double p;
+  double eta;
+  double rho;
+  double lam;
+  double kappa_min;
+  double dt;
+};
+
+struct AlignKernelResult {
+  double J_sq;          // Σ j^2
+  double kappa_sum;     // 更新後 Σ kappa
+  double kappa_sq_sum;  // 更新後 Σ kappa^2（遅延アフィン更新用）
+};
+
+// 1経路分の AlignFlow + UpdateKappa（スカラーカーネルとアンサンブルの共通本体）。
+// 整合流を *j_out に書き、更新後の kappa を返す。p は a.p ではなく引数で受ける
+// （アンサンブルではメンバーごとに違う）。ノイズの有無はコンパイル時に選ぶ
+template <bool kNoise>
+static inline double ssd_align_edge(const AlignKernelArgs& a, double p, double k, double noise,
+                                    double* j_out) {
+  double val = (a.G0 + a.g * k) * p;
+  if (kNoise) val += noise;
+  *j_out = val;
+
+  // 整合仕事: p*j - rho*j^2
+  double gain = a.eta * (p * val - a.rho * val * val);
+  double decay = a.lam * (k - a.kappa_min);
+  return std::max(k + (gain - decay) * a.dt, a.kappa_min);
+}
+
+// 実行時CPU判定（x86 以外は常に false）
+bool ssd_cpu_has_avx2();
+bool ssd_cpu_has_avx512f();
+
+/* --- 格納精度（kappa / w） --- */
+
+// bfloat16 格納値（float の上位16bit）
+struct SSDbf16 {
+  uint16_t bits;
+};
+
+static inline float ssd_bf16_to_float(SSDbf16 v) {
+  uint32_t u = (uint32_t)v.bits << 16;
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+// 下位16bitに dither を足してから切り捨てる。
+// 0x8000 で最近接丸め、一様な値を与えると確率的丸め（期待値が元の値に一致）
+static inline SSDbf16 ssd_bf16_from_float(float f, uint32_t dither) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  u += dither & 0xFFFFu;
+  return SSDbf16{(uint16_t)(u >> 16)};
+}
+
+constexpr uint32_t SSD_ROUND_NEAREST = 0x8000u;
+
+// 格納型ごとの読み書き。compute は演算型（bf16 は float で演算する）
+template <class S> struct SSDStorageTraits;
+
+template <> struct SSDStorageTraits<double> {
+  using compute = double;
+  static double load(double v) { return v; }
+  static double store(double v, uint32_t) { return v; }
+};
+
+template <> struct SSDStorageTraits<float> {
+  using compute = float;
+  static float load(float v) { return v; }
+  static float store(float v, uint32_t) { return v; }
+};
+
+template <> struct SSDStorageTraits<SSDbf16> {
+  using compute = float;
+  static float load(SSDbf16 v) { return ssd_bf16_to_float(v); }
+  static SSDbf16 store(float v, uint32_t dither) { return ssd_bf16_from_float(v, dither); }
+};
+
+// 格納型 S とノイズの有無をコンパイル時に固定した融合カーネル（ステップ実装はこれだけを呼ぶ）。
+// kappa[0..n) を更新し、j[0..n) に整合流を書き出す。ノイズ有りの版は
+// j = (G0 + g*kappa)*p + noise[i]（noise は j と同一バッファ可）、ノイズ無しの版は noise を参照せず、
+// 内側ループに分岐を持たない。float / bf16 は float で演算し、総和は double。
+// bf16 の書き戻しは (添字, step) から作る dither で確率的丸めにする
+// （最近接丸めでは1ステップの微小な更新が丸めで消えて kappa が動かなくなるため）。
+// base は kappa[0] の絶対添字（区間に分けて呼んでも dither が変わらないように）。
+// double / float では step と base は無視する
+template <class S>
+using SSDAlignKernel = AlignKernelResult (*)(const AlignKernelArgs& a, S* kappa,
+                                             typename SSDStorageTraits<S>::compute* j,
+                                             const typename SSDStorageTraits<S>::compute* noise,
+                                             size_t n, uint32_t step, size_t base);
+
+// 実行時CPU判定で実装を選び、noise の有無で特殊化した版を返す。
+// ハンドル作成時に両方を取っておき、ステップでは eps_noise > 0 で添字を引くだけにする
+template <class S>
+SSDAlignKernel<S> ssd_select_align_kernel_t(bool noise);
+
+// 名前指定で特殊化版を取得（"avx512" は double のみ。CPU非対応・未知の名前は nullptr、検証用）
+template <class S>
+SSDAlignKernel<S> ssd_align_kernel_by_name(const char* name, bool noise);
+
+// 選択された実装名（"avx512" / "avx2" / "scalar"）
+template <class S>
+const char* ssd_align_kernel_name();
+
+/* --- RelaxTop 選択（|j| 上位 count 件） --- */
+
+// 選択規則: key > cut.key の全要素 + key == cut.key の先頭 cut.ties 件（添字昇順）
+struct RelaxCut {
+  uint64_t key;
+  size_t ties;
+};
+
+// 非負doubleのビット列は値と同順序なので、符号ビットを落とした j のビット列
+// （= |j|、-0.0 も 0 に揃う）を比較キーにする。仮数の下位 SSD_RELAX_KEY_DROP bit
+// （相対 2^-30 ≒ 1e-9）は落とし、丸め誤差だけ違う |j| を同値（添字順）として扱う。
+// 遅延アフィン変換と逐次更新は同じ j を数 ulp 違いで表し得るので、厳密なキーでは
+// 表現によって緩和する経路が変わってしまう（行 argmax の同着の幅と同じ考え方）
+constexpr int SSD_RELAX_KEY_DROP = 22;
+
+static inline uint64_t ssd_relax_key(double v) {
+  uint64_t u;
+  memcpy(&u, &v, sizeof(u));
+  return u & 0x7FFFFFFFFFFFFFFFull & ~((1ull << SSD_RELAX_KEY_DROP) - 1);
+}
+
+// cut で選ばれる j[begin, end) の添字を昇順に fn(i) へ渡す（key > cut_key の全要素と、
+// key == cut_key の先頭 ties 件）。使い切らなかった同値の枠数を返す
+template <class T, class Fn>
+static inline uint64_t ssd_relax_for_each(const T* j, size_t begin, size_t end, uint64_t cut_key,
+                                          uint64_t ties, Fn&& fn) {
+  for (size_t i = begin; i < end; ++i) {
+    uint64_t key = ssd_relax_key(j[i]);
+    if (key < cut_key) continue;
+    if (key == cut_key) {
+      if (ties == 0) continue;
+      --ties;
+    }
+    fn(i);
+  }
+  return ties;
+}
+
+// ヒストグラム用スクラッチの要素数
+constexpr size_t SSD_RELAX_HIST_SIZE = 2048;
+
+// 基数選択（11bit桁ヒストグラム、最大6パス、索引配列なし）で閾値を求める。
+// count は 1..n。hist は SSD_RELAX_HIST_SIZE 要素。
+RelaxCut ssd_relax_threshold(const double* j, size_t n, size_t count, uint64_t* hist);
+RelaxCut ssd_relax_threshold(const float* j, size_t n, size_t count, uint64_t* hist);
+
+// 1パス分の集計: (key & mask) == prefix を満たす要素の桁 (key >> shift) & digit_mask を hist に加える
+template <class T>
+static inline void ssd_relax_count_digits(const T* j, size_t n, uint64_t prefix, uint64_t mask,
+                                          int shift, uint64_t digit_mask, uint64_t* hist) {
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t key = ssd_relax_key(j[i]);
+    if ((key & mask) == prefix) hist[(key >> shift) & digit_mask]++;
+  }
+}
+
+// 基数選択の本体。各パスの集計は count_digits(prefix, mask, shift, digit_mask, hist)
+// （hist はゼロ済み）に任せるので、区間ごと・スレッドごとに数えて足し合わせてもよい
+// （整数の和なので結果は分け方に依らない）
+template <class CountFn>
+RelaxCut ssd_relax_select(size_t count, uint64_t* hist, CountFn&& count_digits) {
+  // 上位桁から 11,11,11,11,11,9 bit ずつ絞り込む
+  static const int kShifts[] = {53, 42, 31, 20, 9, 0};
+
+  uint64_t prefix = 0;
+  uint64_t mask = 0;
+  size_t remaining = count;
+
+  for (int shift : kShifts) {
+    int width = shift == 0 ? 9 : 11;
+    size_t buckets = (size_t)1 << width;
+    uint64_t digit_mask = buckets - 1;
+    memset(hist, 0, buckets * sizeof(uint64_t));
+    count_digits(prefix, mask, shift, digit_mask, hist);
+
+    // 大きい桁値から数えて count 番目を含むバケットを探す
+    size_t b = buckets - 1;
+    while (hist[b] < remaining) {
+      remaining -= (size_t)hist[b];
+      --b;
+    }
+    prefix |= (uint64_t)b << shift;
+    mask |= digit_mask << shift;
+
+    // バケットを丸ごと取る場合は key >= prefix で確定（同値処理不要）
+    if (hist[b] == remaining && prefix != 0) return {prefix - 1, 0};
+  }
+  return {prefix, remaining};
+}
+
+/* --- 行 argmax（決定論的行動選択） --- */
+
+// 自己列を SSD_ARGMAX_SELF_PENALTY だけ抑制した値の最大 top から丸め誤差の範囲
+// （相対 SSD_ARGMAX_TIE_REL）にある列を同着とみなし、列の小さい方を選ぶ。
+// 遅延アフィン変換（scale*格納値 + offset）と逐次更新は同じ真値を数 ulp 違いで表し得るので、
+// 厳密な比較では表現によって選ぶ列が変わってしまう
+constexpr double SSD_ARGMAX_SELF_PENALTY = 1e-6;
+constexpr double SSD_ARGMAX_TIE_REL = 1e-9;
+
+static inline double ssd_argmax_floor(double top) {
+  return top - SSD_ARGMAX_TIE_REL * std::max(1.0, std::abs(top));
+}
+
+// 行 row の列 0..n-1 から選ぶ。kappa(k) は列 k の真値
+template <class ValueFn>
+static inline int ssd_argmax_pick(int row, int n, ValueFn&& kappa) {
+  auto value = [&](int k) {
+    double v = kappa(k);
+    return k == row ? v - SSD_ARGMAX_SELF_PENALTY : v;  // 自己接続を微妙に抑制
+  };
+  double top = value(0);
+  for (int k = 1; k < n; ++k) top = std::max(top, value(k));
+  double floor = ssd_argmax_floor(top);
+  int best = 0;
+  while (value(best) < floor) ++best;
+  return best;
+}
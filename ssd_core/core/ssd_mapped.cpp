@@ -0,0 +1,93 @@
+﻿#include "ssd_mapped.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+std::unique_ptr<SSDMappedFile> SSDMappedFile::create(const char* path, size_t bytes) {
+    if (!path || bytes == 0) return nullptr;
+
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+    // 最大サイズ付きでマッピングを作るとファイルはその長さまで（ゼロで）伸びる
+    uint64_t size = (uint64_t)bytes;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)(size >> 32),
+                                        (DWORD)size, nullptr);
+    CloseHandle(file);
+    if (!mapping) return nullptr;
+
+    void* base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!base) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    std::unique_ptr<SSDMappedFile> m(new SSDMappedFile());
+    m->base_ = (uint8_t*)base;
+    m->size_ = bytes;
+    m->handle_ = mapping;
+    return m;
+}
+
+SSDMappedFile::~SSDMappedFile() {
+    if (base_) UnmapViewOfFile(base_);
+    if (handle_) CloseHandle((HANDLE)handle_);
+}
+
+void SSDMappedFile::will_need(const void*, size_t) {
+    // PrefetchVirtualMemory は Windows 8 以降のみなので、先読みは
+    // FILE_FLAG_SEQUENTIAL_SCAN とキャッシュマネージャに任せる
+}
+
+#else
+
+std::unique_ptr<SSDMappedFile> SSDMappedFile::create(const char* path, size_t bytes) {
+    if (!path || bytes == 0) return nullptr;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return nullptr;
+    // 切り詰めてから伸ばすので中身はゼロ（疎ファイルならディスクも消費しない）
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // マッピングはファイル記述子を閉じても残る
+    if (base == MAP_FAILED) return nullptr;
+
+    // ステップは全経路を先頭から順に走査する
+    madvise(base, bytes, MADV_SEQUENTIAL);
+
+    std::unique_ptr<SSDMappedFile> m(new SSDMappedFile());
+    m->base_ = (uint8_t*)base;
+    m->size_ = bytes;
+    return m;
+}
+
+SSDMappedFile::~SSDMappedFile() {
+    if (base_) munmap(base_, size_);
+}
+
+void SSDMappedFile::will_need(const void* p, size_t bytes) {
+    // madvise はページ境界から
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = (uintptr_t)p & ~(page - 1);
+    uintptr_t end = (uintptr_t)p + bytes;
+    uintptr_t limit = (uintptr_t)(base_ + size_);
+    if (end > limit) end = limit;
+    if (begin < (uintptr_t)base_ || begin >= end) return;
+    madvise((void*)begin, end - begin, MADV_WILLNEED);
+}
+
+#endif
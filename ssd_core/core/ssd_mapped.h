@@ -0,0 +1,96 @@
+﻿#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+// 大行列の置き場所（非公開）
+//
+// 密行列 kappa / w / j は通常ヒープ上の配列だが、ssd_create_mapped ではファイルに
+// 裏打ちされた共有マッピング上に置く（RAM を超える N 向け）。どちらも SSDBuffer として
+// 同じ data() / operator[] で扱い、ステップ本体は置き場所を区別しない。
+
+// ヒープ上の配列（所有）またはマッピング上の領域（非所有）。T は自明な型（double / float / SSDbf16）
+template <class T>
+class SSDBuffer {
+public:
+    SSDBuffer() : ptr_(nullptr), size_(0) {}
+    SSDBuffer(size_t n, const T& init) : heap_(new T[n]), ptr_(heap_.get()), size_(n) {
+        std::fill(ptr_, ptr_ + n, init);
+    }
+    SSDBuffer(T* mapped, size_t n) : ptr_(mapped), size_(n) {}
+
+    // 未初期化で確保する（大きな領域はページが割り当てられないので、
+    // 呼び出し側が担当スレッドから書き込んで NUMA ノードを決められる）
+    static SSDBuffer uninitialized(size_t n) {
+        SSDBuffer b;
+        b.heap_.reset(new T[n]);
+        b.ptr_ = b.heap_.get();
+        b.size_ = n;
+        return b;
+    }
+
+    SSDBuffer(SSDBuffer&& o) noexcept : heap_(std::move(o.heap_)), ptr_(o.ptr_), size_(o.size_) {
+        o.ptr_ = nullptr;
+        o.size_ = 0;
+    }
+    SSDBuffer& operator=(SSDBuffer&& o) noexcept {
+        heap_ = std::move(o.heap_);
+        ptr_ = o.ptr_;
+        size_ = o.size_;
+        o.ptr_ = nullptr;
+        o.size_ = 0;
+        return *this;
+    }
+    SSDBuffer(const SSDBuffer&) = delete;
+    SSDBuffer& operator=(const SSDBuffer&) = delete;
+
+    T* data() { return ptr_; }
+    const T* data() const { return ptr_; }
+    size_t size() const { return size_; }
+    T& operator[](size_t i) { return ptr_[i]; }
+    const T& operator[](size_t i) const { return ptr_[i]; }
+
+private:
+    std::unique_ptr<T[]> heap_;
+    T* ptr_;
+    size_t size_;
+};
+
+// 読み書き共有でマップしたファイル（作成時に指定サイズへ作り直す。中身はゼロ）
+class SSDMappedFile {
+public:
+    // 領域の境界（SIMD のアラインメントとページ単位のヒントに合わせる）
+    static constexpr size_t kAlign = 4096;
+
+    // 失敗時 nullptr
+    static std::unique_ptr<SSDMappedFile> create(const char* path, size_t bytes);
+    ~SSDMappedFile();
+
+    SSDMappedFile(const SSDMappedFile&) = delete;
+    SSDMappedFile& operator=(const SSDMappedFile&) = delete;
+
+    size_t size() const { return size_; }
+
+    // offset はバイト単位（kAlign の倍数）
+    template <class T>
+    T* at(size_t offset) {
+        return reinterpret_cast<T*>(base_ + offset);
+    }
+
+    // 先読みヒント（[p, p+bytes) をこれから読む）。失敗しても結果には影響しない
+    void will_need(const void* p, size_t bytes);
+
+private:
+    SSDMappedFile() : base_(nullptr), size_(0), handle_(nullptr) {}
+
+    uint8_t* base_;
+    size_t size_;
+    void* handle_;  /* Windows のマッピングハンドル（POSIX では未使用） */
+};
+
+static inline size_t ssd_mapped_round_up(size_t bytes) {
+    return (bytes + SSDMappedFile::kAlign - 1) / SSDMappedFile::kAlign * SSDMappedFile::kAlign;
+}
@@ -0,0 +1,361 @@
+﻿#include "ssd_random.h"
+#include "ssd_kernels.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define SSD_RANDOM_X86 1
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #define SSD_TARGET_AVX2
+    #define SSD_TARGET_AVX512
+  #else
+    #define SSD_TARGET_AVX2 __attribute__((target("avx2")))
+    #define SSD_TARGET_AVX512 __attribute__((target("avx512f")))
+  #endif
+#else
+  #define SSD_RANDOM_X86 0
+#endif
+
+/* --- ziggurat 表（Doornik の ZIGNOR: 128層） --- */
+
+constexpr int kZigLayers = 128;
+constexpr double kZigR = 3.442619855899;           /* 最下層の右端 */
+constexpr double kZigV = 9.91256303526217e-3;      /* 各層の面積 */
+
+struct ZigTables {
+    double x[kZigLayers + 1];  /* 層の右端 */
+    double r[kZigLayers];      /* x[i+1] / x[i]（高速受理の閾値） */
+    double pdf[kZigLayers + 1];  /* exp(-x[i]^2 / 2) */
+
+    ZigTables() {
+        double f = std::exp(-0.5 * kZigR * kZigR);
+        x[0] = kZigV / f;
+        x[1] = kZigR;
+        x[kZigLayers] = 0.0;
+        for (int i = 2; i < kZigLayers; ++i) {
+            x[i] = std::sqrt(-2.0 * std::log(kZigV / x[i - 1] + f));
+            f = std::exp(-0.5 * x[i] * x[i]);
+        }
+        for (int i = 0; i < kZigLayers; ++i) r[i] = x[i + 1] / x[i];
+        for (int i = 0; i <= kZigLayers; ++i) pdf[i] = std::exp(-0.5 * x[i] * x[i]);
+    }
+};
+
+static const ZigTables& zig() {
+    static const ZigTables t;
+    return t;
+}
+
+// 64bit語 → [-1,1) の符号付き一様値（上位52bit）。SIMD 版と同じビット操作で作る
+static inline double zig_u(uint64_t w) {
+    uint64_t bits = (w >> 12) | 0x3FF0000000000000ULL;  /* [1,2) */
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return (d + d) - 3.0;
+}
+
+static inline int zig_layer(uint64_t w) {
+    return (int)(w & (kZigLayers - 1));
+}
+
+/* --- 棄却時の副系列（棄却された語を種とする splitmix64） --- */
+
+struct ZigFallback {
+    uint64_t state;
+
+    explicit ZigFallback(uint64_t w) : state(w) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // (0,1) の一様値（log 用に 0 を除く）
+    double open01() {
+        return ((double)(next() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+};
+
+// 高速受理に失敗した語 w からの続き（くさび領域・裾）
+static double zig_slow(uint64_t w) {
+    const ZigTables& t = zig();
+    ZigFallback fb(w);
+    for (;;) {
+        double u = zig_u(w);
+        int i = zig_layer(w);
+        if (std::fabs(u) < t.r[i]) return u * t.x[i];
+
+        if (i == 0) {
+            // 裾 |x| > R（Marsaglia の方法）
+            double x, y;
+            do {
+                x = std::log(fb.open01()) / kZigR;
+                y = std::log(fb.open01());
+            } while (-2.0 * y < x * x);
+            return u < 0.0 ? x - kZigR : kZigR - x;
+        }
+
+        // くさび: 層の上下端の密度の間で一様に取り、密度曲線の下なら受理
+        double x = u * t.x[i];
+        if (t.pdf[i + 1] + fb.open01() * (t.pdf[i] - t.pdf[i + 1]) < std::exp(-0.5 * x * x)) return x;
+
+        w = fb.next();
+    }
+}
+
+static inline double zig_from_word(uint64_t w) {
+    const ZigTables& t = zig();
+    double u = zig_u(w);
+    int i = zig_layer(w);
+    if (std::fabs(u) < t.r[i]) return u * t.x[i];
+    return zig_slow(w);
+}
+
+// 添字 i の語（ブロック i/2 の前半または後半）
+static inline uint64_t normal_word(const SSDPhilox4x32& r, uint64_t i) {
+    const uint32_t* v = r.v + 2 * (i & 1);
+    return ((uint64_t)v[0] << 32) | v[1];
+}
+
+double ssd_normal_at(uint64_t key, uint64_t step, uint32_t stream, uint64_t i) {
+    SSDPhilox4x32 r = ssd_philox_block(key, step, stream, i >> 1);
+    return zig_from_word(normal_word(r, i));
+}
+
+/* --- 一括生成 --- */
+
+// 偶数添字 begin から pairs 組（2*pairs 個）をスカラーで生成
+static void normal_pairs_scalar(uint64_t key, uint64_t step, uint32_t stream, uint64_t begin,
+                                double* out, size_t pairs) {
+    for (size_t b = 0; b < pairs; ++b) {
+        SSDPhilox4x32 r = ssd_philox_block(key, step, stream, (begin >> 1) + b);
+        out[2 * b] = zig_from_word(normal_word(r, 0));
+        out[2 * b + 1] = zig_from_word(normal_word(r, 1));
+    }
+}
+
+#if SSD_RANDOM_X86
+
+/* --- AVX-512 実装（8ブロック = 16個ずつ） --- */
+// 各64bitレーンの下位32bitに Philox の1語を置き、_mm512_mul_epu32 で 32x32→64 の積を取る
+
+SSD_TARGET_AVX512
+static inline void philox_x8(__m512i c[4], uint32_t k0, uint32_t k1) {
+    const __m512i m0 = _mm512_set1_epi64(0xD2511F53u);
+    const __m512i m1 = _mm512_set1_epi64(0xCD9E8D57u);
+    const __m512i lo32 = _mm512_set1_epi64(0xFFFFFFFFu);
+    for (int round = 0; round < 10; ++round) {
+        __m512i p0 = _mm512_mul_epu32(m0, c[0]);
+        __m512i p1 = _mm512_mul_epu32(m1, c[2]);
+        __m512i n0 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p1, 32), c[1]),
+                                      _mm512_set1_epi64(k0));
+        __m512i n2 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p0, 32), c[3]),
+                                      _mm512_set1_epi64(k1));
+        c[0] = n0;
+        c[1] = _mm512_and_si512(p1, lo32);
+        c[2] = n2;
+        c[3] = _mm512_and_si512(p0, lo32);
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+}
+
+// 語 w から高速受理の値を作る。戻り値は棄却レーンのマスク
+SSD_TARGET_AVX512
+static inline __mmask8 zig_fast_x8(__m512i w, const ZigTables& t, double* out) {
+    __m512i layer = _mm512_and_si512(w, _mm512_set1_epi64(kZigLayers - 1));
+    __m512i bits = _mm512_or_si512(_mm512_srli_epi64(w, 12),
+                                   _mm512_set1_epi64(0x3FF0000000000000LL));
+    __m512d d = _mm512_castsi512_pd(bits);
+    __m512d u = _mm512_sub_pd(_mm512_add_pd(d, d), _mm512_set1_pd(3.0));
+    __m512d abs_u = _mm512_castsi512_pd(
+        _mm512_and_si512(_mm512_castpd_si512(u), _mm512_set1_epi64(0x7FFFFFFFFFFFFFFFLL)));
+    __m512d xi = _mm512_i64gather_pd(layer, t.x, 8);
+    __m512d ri = _mm512_i64gather_pd(layer, t.r, 8);
+    _mm512_storeu_pd(out, _mm512_mul_pd(u, xi));
+    return (__mmask8)~_mm512_cmp_pd_mask(abs_u, ri, _CMP_LT_OQ);
+}
+
+SSD_TARGET_AVX512
+static size_t normal_pairs_avx512(uint64_t key, uint64_t step, uint32_t stream, uint64_t begin,
+                                  double* out, size_t pairs) {
+    const ZigTables& t = zig();
+    const __m512i lane = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m512i lo32 = _mm512_set1_epi64(0xFFFFFFFFu);
+    const __m512i hi24 = _mm512_set1_epi64(0xFFFFFFu);
+    const __m512i tag = _mm512_set1_epi64((uint64_t)stream << 24);
+    const __m512i step_lo = _mm512_set1_epi64((uint32_t)step);
+    const __m512i step_hi = _mm512_set1_epi64((uint32_t)(step >> 32));
+
+    size_t b = 0;
+    for (; b + 8 <= pairs; b += 8) {
+        __m512i idx = _mm512_add_epi64(_mm512_set1_epi64((begin >> 1) + b), lane);
+        __m512i c[4] = {
+            _mm512_and_si512(idx, lo32),
+            _mm512_or_si512(_mm512_and_si512(_mm512_srli_epi64(idx, 32), hi24), tag),
+            step_lo,
+            step_hi,
+        };
+        philox_x8(c, (uint32_t)key, (uint32_t)(key >> 32));
+
+        // 前半語 (v0,v1) が偶数添字、後半語 (v2,v3) が奇数添字
+        __m512i w_even = _mm512_or_si512(_mm512_slli_epi64(c[0], 32), c[1]);
+        __m512i w_odd = _mm512_or_si512(_mm512_slli_epi64(c[2], 32), c[3]);
+        alignas(64) double even[8], odd[8];
+        alignas(64) uint64_t we[8], wo[8];
+        __mmask8 rej_e = zig_fast_x8(w_even, t, even);
+        __mmask8 rej_o = zig_fast_x8(w_odd, t, odd);
+        if (rej_e | rej_o) {
+            _mm512_store_si512((__m512i*)we, w_even);
+            _mm512_store_si512((__m512i*)wo, w_odd);
+            for (int l = 0; l < 8; ++l) {
+                if (rej_e >> l & 1) even[l] = zig_slow(we[l]);
+                if (rej_o >> l & 1) odd[l] = zig_slow(wo[l]);
+            }
+        }
+        double* dst = out + 2 * b;
+        for (int l = 0; l < 8; ++l) {
+            dst[2 * l] = even[l];
+            dst[2 * l + 1] = odd[l];
+        }
+    }
+    return b;
+}
+
+/* --- AVX2 実装（4ブロック = 8個ずつ） --- */
+
+SSD_TARGET_AVX2
+static inline void philox_x4(__m256i c[4], uint32_t k0, uint32_t k1) {
+    const __m256i m0 = _mm256_set1_epi64x(0xD2511F53u);
+    const __m256i m1 = _mm256_set1_epi64x(0xCD9E8D57u);
+    const __m256i lo32 = _mm256_set1_epi64x(0xFFFFFFFFu);
+    for (int round = 0; round < 10; ++round) {
+        __m256i p0 = _mm256_mul_epu32(m0, c[0]);
+        __m256i p1 = _mm256_mul_epu32(m1, c[2]);
+        __m256i n0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c[1]),
+                                      _mm256_set1_epi64x(k0));
+        __m256i n2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c[3]),
+                                      _mm256_set1_epi64x(k1));
+        c[0] = n0;
+        c[1] = _mm256_and_si256(p1, lo32);
+        c[2] = n2;
+        c[3] = _mm256_and_si256(p0, lo32);
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+}
+
+SSD_TARGET_AVX2
+static inline int zig_fast_x4(__m256i w, const ZigTables& t, double* out) {
+    __m256i layer = _mm256_and_si256(w, _mm256_set1_epi64x(kZigLayers - 1));
+    __m256i bits = _mm256_or_si256(_mm256_srli_epi64(w, 12),
+                                   _mm256_set1_epi64x(0x3FF0000000000000LL));
+    __m256d d = _mm256_castsi256_pd(bits);
+    __m256d u = _mm256_sub_pd(_mm256_add_pd(d, d), _mm256_set1_pd(3.0));
+    __m256d abs_u = _mm256_andnot_pd(_mm256_set1_pd(-0.0), u);
+    __m256d xi = _mm256_i64gather_pd(t.x, layer, 8);
+    __m256d ri = _mm256_i64gather_pd(t.r, layer, 8);
+    _mm256_storeu_pd(out, _mm256_mul_pd(u, xi));
+    return ~_mm256_movemask_pd(_mm256_cmp_pd(abs_u, ri, _CMP_LT_OQ)) & 0xF;
+}
+
+SSD_TARGET_AVX2
+static size_t normal_pairs_avx2(uint64_t key, uint64_t step, uint32_t stream, uint64_t begin,
+                                double* out, size_t pairs) {
+    const ZigTables& t = zig();
+    const __m256i lane = _mm256_setr_epi64x(0, 1, 2, 3);
+    const __m256i lo32 = _mm256_set1_epi64x(0xFFFFFFFFu);
+    const __m256i hi24 = _mm256_set1_epi64x(0xFFFFFFu);
+    const __m256i tag = _mm256_set1_epi64x((uint64_t)stream << 24);
+    const __m256i step_lo = _mm256_set1_epi64x((uint32_t)step);
+    const __m256i step_hi = _mm256_set1_epi64x((uint32_t)(step >> 32));
+
+    size_t b = 0;
+    for (; b + 4 <= pairs; b += 4) {
+        __m256i idx = _mm256_add_epi64(_mm256_set1_epi64x((long long)((begin >> 1) + b)), lane);
+        __m256i c[4] = {
+            _mm256_and_si256(idx, lo32),
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi64(idx, 32), hi24), tag),
+            step_lo,
+            step_hi,
+        };
+        philox_x4(c, (uint32_t)key, (uint32_t)(key >> 32));
+
+        __m256i w_even = _mm256_or_si256(_mm256_slli_epi64(c[0], 32), c[1]);
+        __m256i w_odd = _mm256_or_si256(_mm256_slli_epi64(c[2], 32), c[3]);
+        alignas(32) double even[4], odd[4];
+        alignas(32) uint64_t we[4], wo[4];
+        int rej_e = zig_fast_x4(w_even, t, even);
+        int rej_o = zig_fast_x4(w_odd, t, odd);
+        if (rej_e | rej_o) {
+            _mm256_store_si256((__m256i*)we, w_even);
+            _mm256_store_si256((__m256i*)wo, w_odd);
+            for (int l = 0; l < 4; ++l) {
+                if (rej_e >> l & 1) even[l] = zig_slow(we[l]);
+                if (rej_o >> l & 1) odd[l] = zig_slow(wo[l]);
+            }
+        }
+        double* dst = out + 2 * b;
+        for (int l = 0; l < 4; ++l) {
+            dst[2 * l] = even[l];
+            dst[2 * l + 1] = odd[l];
+        }
+    }
+    return b;
+}
+
+#endif /* SSD_RANDOM_X86 */
+
+// 偶数添字 begin から処理できた組数を返す（端数はスカラーで続ける）
+using NormalPairsFn = size_t (*)(uint64_t key, uint64_t step, uint32_t stream, uint64_t begin,
+                                 double* out, size_t pairs);
+
+static size_t normal_pairs_none(uint64_t, uint64_t, uint32_t, uint64_t, double*, size_t) {
+    return 0;
+}
+
+template <NormalPairsFn kSimd>
+static void normal_fill(uint64_t key, uint64_t step, uint32_t stream, uint64_t begin,
+                        double* out, size_t n) {
+    size_t k = 0;
+    if (n > 0 && (begin & 1)) {
+        out[0] = ssd_normal_at(key, step, stream, begin);
+        k = 1;
+    }
+    size_t pairs = (n - k) / 2;
+    size_t done = kSimd(key, step, stream, begin + k, out + k, pairs);
+    normal_pairs_scalar(key, step, stream, begin + k + 2 * done, out + k + 2 * done,
+                        pairs - done);
+    k += 2 * pairs;
+    if (k < n) out[k] = ssd_normal_at(key, step, stream, begin + k);
+}
+
+static NormalFillFn choose_normal_fill() {
+#if SSD_RANDOM_X86
+    if (ssd_cpu_has_avx512f()) return normal_fill<normal_pairs_avx512>;
+    if (ssd_cpu_has_avx2()) return normal_fill<normal_pairs_avx2>;
+#endif
+    return normal_fill<normal_pairs_none>;
+}
+
+void ssd_normal_fill(uint64_t key, uint64_t step, uint32_t stream, uint64_t begin, double* out,
+                     size_t n) {
+    static const NormalFillFn fill = choose_normal_fill();
+    fill(key, step, stream, begin, out, n);
+}
+
+NormalFillFn ssd_normal_fill_by_name(const char* name) {
+    if (!name) return nullptr;
+    if (std::strcmp(name, "scalar") == 0) return normal_fill<normal_pairs_none>;
+#if SSD_RANDOM_X86
+    if (std::strcmp(name, "avx2") == 0 && ssd_cpu_has_avx2()) return normal_fill<normal_pairs_avx2>;
+    if (std::strcmp(name, "avx512") == 0 && ssd_cpu_has_avx512f()) {
+        return normal_fill<normal_pairs_avx512>;
+    }
+#endif
+    return nullptr;
+}
@@ -0,0 +1,137 @@
+﻿#pragma once
+#include "ssd_core.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <random>
+
+// ステップ内の乱数（非公開）
+//
+// 正規乱数（経路ノイズ・跳躍ロジットのノイズ）はどちらのモードでも Philox 語列から
+// SIMD の ziggurat で一括生成する。モードの違いは鍵の取り方だけ:
+// SSD_RNG_MT19937（既定）: 一様乱数と一括生成ごとの鍵を mt19937_64 から呼び出し順に引く。
+// SSD_RNG_PHILOX: 鍵はシード。各乱数は (seed, step, 用途, 添字) だけで決まるため、
+// 経路ループをどう分割・ベクトル化しても同じ値になり、任意のステップの任意の経路の
+// ノイズを単独で再計算できる。
+
+/* --- Philox4x32-10 --- */
+
+struct SSDPhilox4x32 {
+    uint32_t v[4];
+};
+
+static inline void ssd_philox_mulhilo(uint32_t a, uint32_t b, uint32_t* hi, uint32_t* lo) {
+    uint64_t prod = (uint64_t)a * b;
+    *hi = (uint32_t)(prod >> 32);
+    *lo = (uint32_t)prod;
+}
+
+static inline SSDPhilox4x32 ssd_philox4x32_10(SSDPhilox4x32 ctr, uint32_t k0, uint32_t k1) {
+    for (int round = 0; round < 10; ++round) {
+        uint32_t hi0, lo0, hi1, lo1;
+        ssd_philox_mulhilo(0xD2511F53u, ctr.v[0], &hi0, &lo0);
+        ssd_philox_mulhilo(0xCD9E8D57u, ctr.v[2], &hi1, &lo1);
+        ctr = SSDPhilox4x32{{hi1 ^ ctr.v[1] ^ k0, lo1, hi0 ^ ctr.v[3] ^ k1, lo0}};
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    return ctr;
+}
+
+// 用途（カウンタの上位に入れて系列を分ける）
+enum : uint32_t {
+    SSD_STREAM_EDGE_NOISE = 0,   /* AlignFlow の経路ノイズ（添字 = 経路） */
+    SSD_STREAM_LOGIT_NOISE = 1,  /* 跳躍ロジットのノイズ（添字 = ノード） */
+    SSD_STREAM_UNIFORM = 2,      /* 跳躍判定などの一様乱数（添字 = 用途スロット） */
+};
+
+// counter = (添字下位, 添字上位24bit | 用途<<24, step下位, step上位), key = seed
+static inline SSDPhilox4x32 ssd_philox_block(uint64_t seed, uint64_t step, uint32_t stream,
+                                             uint64_t index) {
+    SSDPhilox4x32 ctr{{(uint32_t)index, (uint32_t)(index >> 32 & 0xFFFFFFu) | (stream << 24),
+                       (uint32_t)step, (uint32_t)(step >> 32)}};
+    return ssd_philox4x32_10(ctr, (uint32_t)seed, (uint32_t)(seed >> 32));
+}
+
+// 2語から [0,1) の53bit一様乱数
+static inline double ssd_philox_u01(uint32_t hi, uint32_t lo) {
+    return (double)((((uint64_t)hi << 32) | lo) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* --- 標準正規乱数（Philox 語列 + ziggurat、ssd_random.cpp） --- */
+
+// 添字 i の値はブロック i/2 の 64bit 語（i%2 番目）から ziggurat で作る。
+// 棄却時（約1.2%）だけその語を鍵とする副系列から追加の語を引く。
+// out[k] = z(begin + k)。SIMD 版もスカラー版とビット一致し、区間の切り方に依らない
+void ssd_normal_fill(uint64_t key, uint64_t step, uint32_t stream, uint64_t begin, double* out,
+                     size_t n);
+
+// 1点だけの再計算（ssd_normal_fill と同じ値）
+double ssd_normal_at(uint64_t key, uint64_t step, uint32_t stream, uint64_t i);
+
+// 名前指定で実装を取得（"avx512" / "avx2" / "scalar"、CPU非対応・未知の名前は nullptr、検証用）
+using NormalFillFn = void (*)(uint64_t key, uint64_t step, uint32_t stream, uint64_t begin,
+                              double* out, size_t n);
+NormalFillFn ssd_normal_fill_by_name(const char* name);
+
+/* --- ステップ用乱数源 --- */
+
+// 一括生成のチャンク長（スタック上の一時バッファ）
+constexpr size_t SSD_NORMAL_CHUNK = 256;
+
+struct SSDRandom {
+    int32_t kind;  /* SSD_RNG_MT19937 / SSD_RNG_PHILOX */
+    uint64_t seed;
+    uint64_t step; /* ステップカウンタ（ssd_step ごとに1増える） */
+
+    std::mt19937_64 mt;
+    std::uniform_real_distribution<double> uni01;
+
+    SSDRandom(int32_t k, uint64_t s) : kind(k), seed(s), step(0), mt(s), uni01(0.0, 1.0) {}
+
+    bool counter_based() const { return kind == SSD_RNG_PHILOX; }
+
+    // 一様乱数。slot はステップ内の用途番号（Philox のみ使用、MT は呼び出し順）
+    double uniform(uint32_t slot) {
+        if (!counter_based()) return uni01(mt);
+        SSDPhilox4x32 r = ssd_philox_block(seed, step, SSD_STREAM_UNIFORM, slot);
+        return ssd_philox_u01(r.v[0], r.v[1]);
+    }
+
+    // 正規乱数列の鍵。MT は1回の一括生成ごとに1語だけ引く（正規乱数そのものは
+    // SIMD の Philox + ziggurat で作る）。Philox はシードそのもの
+    uint64_t normal_key() { return counter_based() ? seed : mt(); }
+
+    // 跳躍ロジットのノイズ out[k] = z(k)、k in [0, n)
+    void fill_logit_noise(double* out, size_t n) {
+        ssd_normal_fill(normal_key(), step, SSD_STREAM_LOGIT_NOISE, 0, out, n);
+    }
+
+    // 経路ノイズ out[i*stride] = scale * z(i)、i in [0, n)
+    template <class T>
+    void fill_edge_noise(T* out, size_t n, double scale, size_t stride = 1) {
+        fill_edge_noise_keyed(normal_key(), out, 0, n, scale, stride);
+    }
+
+    // Philox のみ: 経路 [begin, end) のノイズ（分割しても同じ値）
+    template <class T>
+    void fill_edge_noise_range(T* out, size_t begin, size_t end, double scale,
+                               size_t stride = 1) const {
+        fill_edge_noise_keyed(seed, out, begin, end, scale, stride);
+    }
+
+    // 鍵を指定して経路 [begin, end) のノイズを作る。1回の normal_key() で取った鍵を
+    // 区間ごとに使い回せば、fill_edge_noise で一括生成した場合と同じ値になる
+    template <class T>
+    void fill_edge_noise_keyed(uint64_t key, T* out, size_t begin, size_t end, double scale,
+                               size_t stride) const {
+        double buf[SSD_NORMAL_CHUNK];
+        for (size_t c = begin; c < end; c += SSD_NORMAL_CHUNK) {
+            size_t len = end - c < SSD_NORMAL_CHUNK ? end - c : SSD_NORMAL_CHUNK;
+            ssd_normal_fill(key, step, SSD_STREAM_EDGE_NOISE, c, buf, len);
+            T* dst = out + c * stride;
+            for (size_t k = 0; k < len; ++k) dst[k * stride] = (T)(scale * buf[k]);
+        }
+    }
+};
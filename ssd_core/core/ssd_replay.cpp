@@ -0,0 +1,280 @@
+﻿#include "ssd_replay.h"
+#include "ssd_handle.h"
+#include "ssd_state.h"
+
+#include <cstring>
+#include <memory>
+#include <new>
+
+// 再生ログの記録と再生（ssd_record_start / ssd_record_stop / ssd_replay）
+
+namespace {
+
+const char kMagic[8] = {'S', 'S', 'D', 'R', 'P', 'L', 'A', 'Y'};
+
+constexpr size_t kParamCount = sizeof(SSDParams) / sizeof(double);
+
+void store_f64(uint8_t* p, double v) {
+    uint64_t u;
+    std::memcpy(&u, &v, 8);
+    ssd_store_le64(p, u);
+}
+
+double load_f64(const uint8_t* p) {
+    uint64_t u = ssd_load_le64(p);
+    double v;
+    std::memcpy(&v, &u, 8);
+    return v;
+}
+
+// 疎グラフは threads を無視するので常に 1
+int32_t current_threads(const SSDHandle* h) {
+    return h->pool ? h->pool->size() : 1;
+}
+
+}  // namespace
+
+SSDRecorder::SSDRecorder(FILE* file, uint64_t checkpoint_interval)
+    : f(file), interval(checkpoint_interval), next_checkpoint(0),
+      batch(SSD_REPLAY_INPUT_BATCH * 16), pending(0), error(SSD_STATE_OK) {}
+
+SSDRecorder::~SSDRecorder() {
+    close();
+}
+
+int32_t SSDRecorder::begin(SSDHandle* h, int32_t threads) {
+    uint8_t head[SSD_REPLAY_HEADER] = {};
+    std::memcpy(head, kMagic, sizeof(kMagic));
+    ssd_store_le32(head + 8, SSD_REPLAY_VERSION);
+    ssd_store_le64(head + 16, interval);
+    if (fwrite(head, 1, sizeof(head), f) != sizeof(head)) error = SSD_STATE_ERR_IO;
+    this->threads(threads);
+    checkpoint(h);
+    return error;
+}
+
+void SSDRecorder::before_step(SSDHandle* h, double p, double dt) {
+    if (error != SSD_STATE_OK) return;
+    if (interval > 0 && h->rng.step >= next_checkpoint) checkpoint(h);
+    uint8_t* rec = batch.data() + pending * 16;
+    store_f64(rec, p);
+    store_f64(rec + 8, dt);
+    if (++pending == SSD_REPLAY_INPUT_BATCH) flush();
+}
+
+void SSDRecorder::params(const SSDParams& prm) {
+    flush();
+    uint8_t payload[kParamCount * 8];
+    const double* v = (const double*)&prm;
+    for (size_t k = 0; k < kParamCount; ++k) store_f64(payload + 8 * k, v[k]);
+    write_record(SSD_REPLAY_PARAMS, payload, sizeof(payload));
+}
+
+void SSDRecorder::threads(int32_t threads) {
+    flush();
+    uint8_t payload[8] = {};
+    ssd_store_le32(payload, (uint32_t)threads);
+    write_record(SSD_REPLAY_THREADS, payload, sizeof(payload));
+}
+
+void SSDRecorder::checkpoint(SSDHandle* h) {
+    // 像の大きさは書き終えるまで分からないので、レコードヘッダは後から埋める
+    flush();
+    if (error != SSD_STATE_OK) return;
+    uint64_t start;
+    uint8_t head[SSD_REPLAY_RECORD_HEADER + 8] = {};
+    ssd_store_le32(head, SSD_REPLAY_CHECKPOINT);
+    ssd_store_le64(head + SSD_REPLAY_RECORD_HEADER, h->rng.step);
+    if (!ssd_file_tell(f, &start) || fwrite(head, 1, sizeof(head), f) != sizeof(head)) {
+        error = SSD_STATE_ERR_IO;
+        return;
+    }
+    uint64_t image = 0;
+    int32_t rc = ssd_state_write(h, f, &image);
+    if (rc != SSD_STATE_OK) {
+        error = rc;
+        return;
+    }
+    uint8_t size[8];
+    ssd_store_le64(size, 8 + image);
+    uint64_t end = start + sizeof(head) + image;
+    if (!ssd_file_seek(f, start + 8) || fwrite(size, 1, 8, f) != 8 || !ssd_file_seek(f, end)) {
+        error = SSD_STATE_ERR_IO;
+        return;
+    }
+    next_checkpoint = h->rng.step + interval;
+}
+
+void SSDRecorder::flush() {
+    if (pending == 0) return;
+    write_record(SSD_REPLAY_INPUTS, batch.data(), pending * 16);
+    pending = 0;
+}
+
+bool SSDRecorder::write_record(uint32_t type, const void* payload, size_t bytes) {
+    if (error != SSD_STATE_OK) return false;
+    uint8_t head[SSD_REPLAY_RECORD_HEADER] = {};
+    ssd_store_le32(head, type);
+    ssd_store_le64(head + 8, bytes);
+    if (fwrite(head, 1, sizeof(head), f) != sizeof(head) || fwrite(payload, 1, bytes, f) != bytes) {
+        error = SSD_STATE_ERR_IO;
+        return false;
+    }
+    return true;
+}
+
+int32_t SSDRecorder::close() {
+    if (!f) return error;
+    flush();
+    if (fclose(f) != 0 && error == SSD_STATE_OK) error = SSD_STATE_ERR_IO;
+    f = nullptr;
+    return error;
+}
+
+/* --- 再生 --- */
+
+namespace {
+
+struct RecordHeader {
+    uint32_t type;
+    uint64_t payload;
+    uint64_t offset;  /* payload の位置 */
+};
+
+// 次のレコードのヘッダを読む。末尾・書きかけのレコードなら false
+bool next_record(FILE* f, uint64_t length, uint64_t pos, RecordHeader* out) {
+    uint8_t head[SSD_REPLAY_RECORD_HEADER];
+    if (length - pos < sizeof(head) || !ssd_file_seek(f, pos) ||
+        fread(head, 1, sizeof(head), f) != sizeof(head)) {
+        return false;
+    }
+    out->type = ssd_load_le32(head);
+    out->payload = ssd_load_le64(head + 8);
+    out->offset = pos + sizeof(head);
+    return out->payload <= length - out->offset;
+}
+
+int32_t replay(FILE* f, uint64_t step, SSDHandle** out) {
+    uint8_t head[SSD_REPLAY_HEADER];
+    uint64_t length;
+    if (fread(head, 1, sizeof(head), f) != sizeof(head)) return SSD_STATE_ERR_FORMAT;
+    if (std::memcmp(head, kMagic, sizeof(kMagic)) != 0 ||
+        ssd_load_le32(head + 8) != SSD_REPLAY_VERSION) {
+        return SSD_STATE_ERR_FORMAT;
+    }
+    if (!ssd_file_length(f, &length)) return SSD_STATE_ERR_IO;
+
+    // step 以前で最後のチェックポイントと、その時点のスレッド設定を探す
+    // （INPUTS は中身を読まずに飛ばす）
+    bool found = false;
+    RecordHeader cp{};
+    int32_t threads = 1, cp_threads = 1;
+    RecordHeader r;
+    uint8_t buf[8];
+    for (uint64_t pos = SSD_REPLAY_HEADER; next_record(f, length, pos, &r); pos = r.offset + r.payload) {
+        if (r.type == SSD_REPLAY_THREADS) {
+            if (r.payload != 8 || fread(buf, 1, 8, f) != 8) return SSD_STATE_ERR_FORMAT;
+            threads = (int32_t)ssd_load_le32(buf);
+        } else if (r.type == SSD_REPLAY_CHECKPOINT) {
+            if (r.payload < 8) break;  // 書きかけ
+            if (fread(buf, 1, 8, f) != 8) return SSD_STATE_ERR_IO;
+            if (ssd_load_le64(buf) > step) break;
+            found = true;
+            cp = r;
+            cp_threads = threads;
+        }
+    }
+    if (!found) return SSD_STATE_ERR_ARG;
+
+    SSDHandle* loaded = nullptr;
+    int32_t rc = ssd_state_load(f, cp.offset + 8, cp.payload - 8, &loaded);
+    if (rc != SSD_STATE_OK) return rc;
+    std::unique_ptr<SSDHandle> h(loaded);
+    if (cp_threads != 1) ssd_set_threads(h.get(), cp_threads);
+
+    // チェックポイント以後の記録を step に達するまで与え直す。
+    // step の直後に行われた設定変更（次のステップより前）も反映する
+    std::vector<uint8_t> payload;
+    for (uint64_t pos = cp.offset + cp.payload; next_record(f, length, pos, &r); pos = r.offset + r.payload) {
+        if (r.type == SSD_REPLAY_CHECKPOINT) continue;
+        if (r.type == SSD_REPLAY_INPUTS && h->rng.step == step) break;
+        try {
+            payload.resize((size_t)r.payload);
+        } catch (const std::bad_alloc&) {
+            return SSD_STATE_ERR_ALLOC;
+        }
+        if (!ssd_file_seek(f, r.offset) || fread(payload.data(), 1, payload.size(), f) != payload.size()) {
+            return SSD_STATE_ERR_IO;
+        }
+        if (r.type == SSD_REPLAY_INPUTS) {
+            if (r.payload % 16 != 0) return SSD_STATE_ERR_FORMAT;
+            size_t k = 0;
+            for (; k < payload.size() && h->rng.step < step; k += 16) {
+                ssd_step(h.get(), load_f64(&payload[k]), load_f64(&payload[k + 8]), nullptr);
+            }
+            if (k < payload.size()) break;  // 以後の記録は step より後
+        } else if (r.type == SSD_REPLAY_PARAMS) {
+            if (r.payload != kParamCount * 8) return SSD_STATE_ERR_FORMAT;
+            SSDParams prm;
+            double* v = (double*)&prm;
+            for (size_t k = 0; k < kParamCount; ++k) v[k] = load_f64(&payload[8 * k]);
+            // 記録されるのは適用された設定だけなので、拒否されたら記録が壊れている
+            if (!ssd_set_params(h.get(), &prm)) return SSD_STATE_ERR_FORMAT;
+        } else if (r.type == SSD_REPLAY_THREADS) {
+            if (r.payload != 8) return SSD_STATE_ERR_FORMAT;
+            ssd_set_threads(h.get(), (int32_t)ssd_load_le32(payload.data()));
+        }
+    }
+    if (h->rng.step != step) return SSD_STATE_ERR_ARG;  // 記録の範囲外
+
+    *out = h.release();
+    return SSD_STATE_OK;
+}
+
+}  // namespace
+
+extern "C" int32_t ssd_record_start(SSDHandle* h, const char* path, uint64_t checkpoint_interval) {
+    if (!h || !path || h->recorder) return SSD_STATE_ERR_ARG;
+    // マッピング版は行ブロック単位の総和で、復元先のヒープ版とは丸めが揃わない
+    if (h->dense.backing || (h->dense_f32 && h->dense_f32->backing) ||
+        (h->dense_bf16 && h->dense_bf16->backing)) {
+        return SSD_STATE_ERR_ARG;
+    }
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return SSD_STATE_ERR_IO;
+    std::unique_ptr<SSDRecorder> rec;
+    try {
+        rec.reset(new SSDRecorder(f, checkpoint_interval));
+    } catch (const std::bad_alloc&) {
+        fclose(f);
+        return SSD_STATE_ERR_ALLOC;
+    }
+    int32_t rc = rec->begin(h, current_threads(h));
+    if (rc != SSD_STATE_OK) return rc;
+    h->recorder = std::move(rec);
+    return SSD_STATE_OK;
+}
+
+extern "C" int32_t ssd_record_stop(SSDHandle* h) {
+    if (!h || !h->recorder) return SSD_STATE_ERR_ARG;
+    int32_t rc = h->recorder->close();
+    h->recorder.reset();
+    return rc;
+}
+
+extern "C" SSDHandle* ssd_replay(const char* path, uint64_t step, int32_t* err) {
+    int32_t rc = SSD_STATE_ERR_ARG;
+    SSDHandle* h = nullptr;
+    if (path) {
+        FILE* f = fopen(path, "rb");
+        if (f) {
+            rc = replay(f, step, &h);
+            fclose(f);
+        } else {
+            rc = SSD_STATE_ERR_IO;
+        }
+    }
+    if (err) *err = rc;
+    return h;
+}
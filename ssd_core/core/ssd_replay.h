@@ -0,0 +1,68 @@
+﻿#pragma once
+#include "ssd_core.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+// 再生ログ形式（非公開、ssd_record_start / ssd_replay）
+//
+// ステップの入力（p, dt）と状態を変える API 呼び出しだけを記録順に並べ、一定間隔で
+// 状態の像（ssd_save_state と同じ形式）をチェックポイントとして挟む。ステップは決定論的なので、
+// チェックポイントから同じ入力を与え直せば元の軌道とビット一致する。
+// すべて小端順。固定ヘッダ（32B）の後にレコードが続く。
+//
+//   0  char     magic[8]      "SSDRPLAY"
+//   8  u32      version
+//  12  u32      reserved
+//  16  u64      checkpoint_interval
+//  24  u64      reserved
+//  レコード: u32 type, u32 reserved, u64 payload_bytes, payload
+//
+// 書き込み中に止まったログは、最後の完全なレコードまでを有効とみなす。
+
+constexpr uint32_t SSD_REPLAY_VERSION = 1;
+constexpr size_t SSD_REPLAY_HEADER = 32;
+constexpr size_t SSD_REPLAY_RECORD_HEADER = 16;
+// INPUTS レコード1件に溜める入力の数
+constexpr size_t SSD_REPLAY_INPUT_BATCH = 4096;
+
+enum : uint32_t {
+    SSD_REPLAY_INPUTS = 1,      /* {f64 p, f64 dt} × 件数（ステップ順） */
+    SSD_REPLAY_PARAMS = 2,      /* ssd_set_params の内容（SSDParams の double 列） */
+    SSD_REPLAY_THREADS = 3,     /* i32 threads, u32 reserved（開始時の設定・ssd_set_threads） */
+    SSD_REPLAY_CHECKPOINT = 4,  /* u64 step, 状態の像 */
+};
+
+// 記録中のハンドルが持つ書き出し側。
+// ステップごとの仕事は入力16バイトを手元の塊に書くことだけで、塊が満ちたら1回で書き出す
+struct SSDRecorder {
+    FILE* f;
+    uint64_t interval;          /* チェックポイント間隔（0 なら開始時だけ） */
+    uint64_t next_checkpoint;   /* 次にチェックポイントを書くステップ番号 */
+    std::vector<uint8_t> batch; /* 未書き出しの入力（小端順、開始時に確保） */
+    size_t pending;             /* batch 内の入力数 */
+    int32_t error;              /* 最初の書き出し失敗（SSD_STATE_ERR_*）。以後は何も書かない */
+
+    SSDRecorder(FILE* file, uint64_t checkpoint_interval);
+    ~SSDRecorder();
+
+    SSDRecorder(const SSDRecorder&) = delete;
+    SSDRecorder& operator=(const SSDRecorder&) = delete;
+
+    // ヘッダ・スレッド設定・最初のチェックポイント
+    int32_t begin(SSDHandle* h, int32_t threads);
+    // ステップの直前（ssd_step_impl から）
+    void before_step(SSDHandle* h, double p, double dt);
+    void params(const SSDParams& prm);
+    void threads(int32_t threads);
+    // 残りを書き出して閉じる。最初の失敗を返す
+    int32_t close();
+
+private:
+    void checkpoint(SSDHandle* h);
+    void flush();
+    bool write_record(uint32_t type, const void* payload, size_t bytes);
+};
@@ -0,0 +1,284 @@
+﻿#include "ssd_handle.h"
+
+#include <algorithm>
+#include <cmath>
+
+/* --- 疎グラフバックエンド --- */
+
+static inline double relaxed(double kappa, double eps, double kappa_min) {
+    return std::max(kappa - eps, kappa_min);
+}
+
+static inline std::vector<SparseEdge>::const_iterator
+lower_col(const std::vector<SparseEdge>& row, int col) {
+    return std::lower_bound(row.begin(), row.end(), col,
+        [](const SparseEdge& e, int c) { return e.col < c; });
+}
+
+SparseGraph::SparseGraph(int n)
+    : N(n), total((uint64_t)n * (uint64_t)n), rows(n), touched(0) {
+    runs.push_back(KappaRun{0, total, total, 0.0, 0.0});
+}
+
+size_t SparseGraph::find_run(uint64_t e) const {
+    // begin <= e を満たす最後の区間
+    auto it = std::upper_bound(runs.begin(), runs.end(), e,
+        [](uint64_t v, const KappaRun& r) { return v < r.begin; });
+    return (size_t)(it - runs.begin()) - 1;
+}
+
+void SparseGraph::merge_runs() {
+    // 隣接区間が同値になったら統合（kappa_min でのクリップ後など）
+    size_t out = 0;
+    for (size_t i = 1; i < runs.size(); ++i) {
+        if (runs[i].kappa == runs[out].kappa) {
+            runs[out].end = runs[i].end;
+            runs[out].untouched += runs[i].untouched;
+        } else {
+            runs[++out] = runs[i];
+        }
+    }
+    runs.resize(out + 1);
+}
+
+AlignKernelResult SparseGraph::align_update(SSDHandle& h, double p, double dt) {
+    // 疎表現は未接触経路が同一写像に従うことを前提とするので、eps_noise > 0 は
+    // 作成時と ssd_set_params で拒否している（常にノイズ無し）
+    const SSDParams& prm = h.prm;
+    AlignKernelResult r{0.0, 0.0, 0.0};
+
+    auto update = [&](double& kappa, double& j) {
+        double k = kappa;
+        double val = (prm.G0 + prm.g * k) * p;
+        j = val;
+
+        // 整合仕事: p*j - rho*j^2
+        double gain = prm.eta * (p * val - prm.rho * val * val);
+        double decay = prm.lam * (k - prm.kappa_min);
+        kappa = std::max(k + (gain - decay) * dt, prm.kappa_min);
+    };
+
+    for (KappaRun& run : runs) {
+        update(run.kappa, run.j);
+        double count = (double)run.untouched;
+        r.J_sq += count * (run.j * run.j);
+        r.kappa_sum += count * run.kappa;
+        r.kappa_sq_sum += count * (run.kappa * run.kappa);
+    }
+    for (int32_t row : active_rows) {
+        for (SparseEdge& e : rows[row]) {
+            update(e.kappa, e.j);
+            r.J_sq += e.j * e.j;
+            r.kappa_sum += e.kappa;
+            r.kappa_sq_sum += e.kappa * e.kappa;
+        }
+    }
+
+    merge_runs();
+    return r;
+}
+
+void SparseGraph::row_values(int row, double* out, int len) const {
+    copy_block(row, 0, 1, len, out);
+}
+
+void SparseGraph::copy_block(int row0, int col0, int nrows, int ncols, double* out) const {
+    for (int r = 0; r < nrows; ++r) {
+        int row = row0 + r;
+        double* dst = out + (size_t)r * ncols;
+        // 区間の値で埋めてから接触経路を上書き
+        uint64_t base = (uint64_t)row * N + col0;
+        for (size_t ri = find_run(base); ri < runs.size() && runs[ri].begin < base + ncols; ++ri) {
+            uint64_t b = std::max(runs[ri].begin, base);
+            uint64_t e = std::min(runs[ri].end, base + ncols);
+            std::fill(dst + (b - base), dst + (e - base), runs[ri].kappa);
+        }
+        const std::vector<SparseEdge>& edges = rows[row];
+        for (auto it = lower_col(edges, col0); it != edges.end() && it->col < col0 + ncols; ++it) {
+            dst[it->col - col0] = it->kappa;
+        }
+    }
+}
+
+void SparseGraph::add_edge(int row, int col, double d_kappa, double d_w) {
+    std::vector<SparseEdge>& r = rows[row];
+    auto it = r.begin() + (lower_col(r, col) - r.cbegin());
+    if (it == r.end() || it->col != col) {
+        // 初接触: 所属区間の値と今ステップの整合流を引き継ぐ
+        KappaRun& run = runs[find_run((uint64_t)row * N + col)];
+        run.untouched--;
+        if (r.empty()) active_rows.push_back(row);
+        it = r.insert(it, SparseEdge{col, run.kappa, 0.0, run.j});
+        touched++;
+    }
+    it->w += d_w;
+    it->kappa += d_kappa;
+}
+
+void SparseGraph::relax_top(size_t count, double eps, double kappa_min) {
+    // 区間（未接触経路の塊）と接触経路を |j| のキーで降順に並べ、閾値を決める
+    groups.clear();
+    for (size_t ri = 0; ri < runs.size(); ++ri) {
+        if (runs[ri].untouched == 0) continue;
+        groups.push_back(RelaxGroup{ssd_relax_key(runs[ri].j), runs[ri].untouched,
+                                    (int64_t)ri, 0, 0});
+    }
+    for (int32_t row : active_rows) {
+        const std::vector<SparseEdge>& r = rows[row];
+        for (size_t pos = 0; pos < r.size(); ++pos) {
+            groups.push_back(RelaxGroup{ssd_relax_key(r[pos].j), 1, -1, row, (int32_t)pos});
+        }
+    }
+    std::sort(groups.begin(), groups.end(),
+        [](const RelaxGroup& a, const RelaxGroup& b) { return a.key > b.key; });
+
+    // 降順に同値群ごと数え、count 番目を含む群のキーを閾値とする
+    uint64_t above = 0;    /* 閾値より大きい要素数 */
+    uint64_t cut_key = 0;
+    for (size_t gi = 0; gi < groups.size();) {
+        size_t gj = gi;
+        uint64_t same = 0;
+        while (gj < groups.size() && groups[gj].key == groups[gi].key) same += groups[gj++].count;
+        cut_key = groups[gi].key;
+        if (above + same >= count) break;
+        above += same;
+        gi = gj;
+    }
+    uint64_t need = count > above ? count - above : 0;
+
+    // 1) 閾値より大きいものは全て緩和
+    for (const RelaxGroup& g : groups) {
+        if (g.key <= cut_key) break;
+        if (g.run >= 0) {
+            runs[g.run].kappa = relaxed(runs[g.run].kappa, eps, kappa_min);
+        } else {
+            SparseEdge& e = rows[g.row][g.pos];
+            e.kappa = relaxed(e.kappa, eps, kappa_min);
+        }
+    }
+
+    // 2) 閾値と同値のものは線形添字の小さい順に need 件
+    //    区間をすべて添字順に走査し、同値区間は未接触経路と同値接触経路を、
+    //    非同値区間は同値接触経路だけを数える
+    for (size_t ri = 0; ri < runs.size() && need > 0; ++ri) {
+        KappaRun& run = runs[ri];
+        bool tie_run = run.untouched > 0 && ssd_relax_key(run.j) == cut_key;
+        double run_relaxed = relaxed(run.kappa, eps, kappa_min);
+
+        uint64_t untouched_taken = 0;
+        uint64_t cut = run.begin;  /* 採用済み範囲の終端 */
+
+        int32_t first_row = (int32_t)(run.begin / (uint64_t)N);
+        int32_t last_row = (int32_t)((run.end - 1) / (uint64_t)N);
+        for (int32_t row = first_row; row <= last_row && need > 0; ++row) {
+            uint64_t base = (uint64_t)row * N;
+            uint64_t sb = std::max(run.begin, base);
+            uint64_t se = std::min(run.end, base + N);
+            std::vector<SparseEdge>& r = rows[row];
+            if (!tie_run && r.empty()) continue;
+
+            auto first = r.begin() + (lower_col(r, (int)(sb - base)) - r.cbegin());
+            auto last = r.begin() + (lower_col(r, (int)(se - base)) - r.cbegin());
+
+            uint64_t touched_in_seg = (uint64_t)(last - first);
+            uint64_t ties_in_seg = 0;
+            for (auto it = first; it != last; ++it) {
+                if (ssd_relax_key(it->j) == cut_key) ties_in_seg++;
+            }
+            uint64_t free_in_seg = tie_run ? (se - sb) - touched_in_seg : 0;
+
+            if (free_in_seg + ties_in_seg <= need) {
+                // 区間内の行セグメントを丸ごと採用
+                for (auto it = first; it != last; ++it) {
+                    if (ssd_relax_key(it->j) == cut_key) it->kappa = relaxed(it->kappa, eps, kappa_min);
+                }
+                untouched_taken += free_in_seg;
+                need -= free_in_seg + ties_in_seg;
+                cut = se;
+                continue;
+            }
+
+            // セグメント内で打ち切り位置を探す
+            uint64_t pos = sb;
+            for (auto it = first; it != last && need > 0; ++it) {
+                uint64_t e = base + (uint64_t)it->col;
+                if (tie_run) {
+                    uint64_t gap = e - pos;
+                    if (gap >= need) {
+                        untouched_taken += need;
+                        cut = pos + need;
+                        need = 0;
+                        break;
+                    }
+                    untouched_taken += gap;
+                    need -= gap;
+                }
+                if (ssd_relax_key(it->j) == cut_key) {
+                    it->kappa = relaxed(it->kappa, eps, kappa_min);
+                    if (--need == 0) cut = e + 1;
+                }
+                pos = e + 1;
+            }
+            if (need > 0 && tie_run) {
+                untouched_taken += need;
+                cut = pos + need;
+                need = 0;
+            }
+        }
+
+        if (!tie_run || untouched_taken == 0) continue;
+        if (cut >= run.end) {
+            run.kappa = run_relaxed;
+            continue;
+        }
+        // 区間を [begin, cut) 緩和済み と [cut, end) に分割
+        KappaRun tail = run;
+        tail.begin = cut;
+        tail.untouched = run.untouched - untouched_taken;
+        run.end = cut;
+        run.untouched = untouched_taken;
+        run.kappa = run_relaxed;
+        runs.insert(runs.begin() + ri + 1, tail);
+        ++ri;
+    }
+
+    merge_runs();
+}
+
+int SparseGraph::argmax_row(int row) const {
+    // 密行列と同じ規則（ssd_argmax_floor）。候補を2回なめて、最大と同着の最小列を求める
+    const std::vector<SparseEdge>& r = rows[row];
+    uint64_t base = (uint64_t)row * N;
+    auto for_each_candidate = [&](auto&& consider) {
+        auto value = [&](int col, double v) {
+            consider(col, col == row ? v - SSD_ARGMAX_SELF_PENALTY : v);  // 自己接続を微妙に抑制
+        };
+        for (const SparseEdge& e : r) value(e.col, e.kappa);
+
+        // 各区間セグメントでは未接触列は同値なので先頭の未接触列だけが候補。
+        // 先頭が自己列なら次の未接触列も候補にする
+        for (size_t ri = find_run(base); ri < runs.size() && runs[ri].begin < base + N; ++ri) {
+            int cs = (int)(std::max(runs[ri].begin, base) - base);
+            int ce = (int)(std::min(runs[ri].end, base + N) - base);
+
+            auto it = lower_col(r, cs);
+            for (int c = cs; c < ce; ++c) {
+                if (it != r.end() && it->col == c) {
+                    ++it;
+                    continue;
+                }
+                value(c, runs[ri].kappa);
+                if (c != row) break;
+            }
+        }
+    };
+
+    double top = -1e300;
+    for_each_candidate([&](int, double v) { top = std::max(top, v); });
+    double floor = ssd_argmax_floor(top);
+    int best = N;
+    for_each_candidate([&](int col, double v) {
+        if (v >= floor && col < best) best = col;
+    });
+    return best;
+}
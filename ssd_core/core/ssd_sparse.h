@@ -0,0 +1,62 @@
+﻿#pragma once
+#include "ssd_kernels.h"
+
+#include <stdint.h>
+#include <vector>
+
+struct SSDHandle;
+
+// 疎グラフバックエンド（非公開、ssd_create_sparse）
+//
+// ノイズ無しでは未接触の経路はすべて同じ写像で更新されるため、値の等しい
+// 未接触経路を線形添字の区間（KappaRun）にまとめ、再配線・ε探索で触れた
+// 経路だけを行ごとの列昇順配列に個別保持する。RelaxTop の同値は添字の
+// 小さい順に採るので、緩和される未接触経路は常に区間の先頭部分となり、
+// 区間の分割だけで密行列と同じ結果を表現できる。
+// ステップ・メモリとも O(区間数 + 接触経路数 + 行数)。
+
+struct SparseEdge {
+    int32_t col;
+    double kappa;
+    double w;
+    double j;     /* 直近ステップの整合流（RelaxTop 用） */
+};
+
+struct KappaRun {
+    uint64_t begin;      /* 線形添字 [begin, end) */
+    uint64_t end;
+    uint64_t untouched;  /* 区間内の未接触経路数 */
+    double kappa;
+    double j;
+};
+
+struct RelaxGroup {
+    uint64_t key;    /* ssd_relax_key(j) */
+    uint64_t count;
+    int64_t run;     /* 区間なら添字、接触経路なら -1 */
+    int32_t row;
+    int32_t pos;     /* 行内位置 */
+};
+
+struct SparseGraph {
+    int N;
+    uint64_t total;                              /* N*N */
+    std::vector<std::vector<SparseEdge>> rows;   /* 接触経路（列昇順） */
+    std::vector<int32_t> active_rows;            /* 接触経路を持つ行 */
+    std::vector<KappaRun> runs;                  /* 未接触経路の区間（添字昇順で全域を被覆） */
+    std::vector<RelaxGroup> groups;              /* RelaxTop スクラッチ */
+    uint64_t touched;
+
+    explicit SparseGraph(int n);
+
+    AlignKernelResult align_update(SSDHandle& h, double p, double dt);
+    void row_values(int row, double* out, int len) const;
+    void copy_block(int row0, int col0, int nrows, int ncols, double* out) const;
+    void add_edge(int row, int col, double d_kappa, double d_w);
+    void relax_top(size_t count, double eps, double kappa_min);
+    int argmax_row(int row) const;
+
+private:
+    size_t find_run(uint64_t e) const;
+    void merge_runs();
+};
@@ -0,0 +1,626 @@
+﻿#include "ssd_state.h"
+#include "ssd_handle.h"
+
+#include <algorithm>
+#include <cstring>
+#include <locale>
+#include <new>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+// 状態の保存・復元（ssd_save_state / ssd_load_state）
+//
+// 保存するのはステップをまたいで持ち越される状態だけ。整合流 j・ロジット・
+// RelaxTop ヒストグラムは毎ステップ書き直すスクラッチ、行 argmax キャッシュは
+// 格納値から同じ結果を再計算できるので保存しない（復元後のハンドルでは未計算）。
+
+namespace {
+
+const char kMagic[8] = {'S', 'S', 'D', 'S', 'T', 'A', 'T', 'E'};
+// 大容量区画の読み込み単位（読んだ直後のキャッシュに載っている間に checksum を取る）
+const size_t kIoChunk = (size_t)8 << 20;
+// 大端ホストで1回に変換するバイト数
+const size_t kSwapChunk = (size_t)64 << 10;
+
+bool host_little_endian() {
+    const uint16_t one = 1;
+    uint8_t b;
+    std::memcpy(&b, &one, 1);
+    return b == 1;
+}
+
+size_t align_up(size_t x) {
+    return (x + SSD_STATE_ALIGN - 1) & ~(SSD_STATE_ALIGN - 1);
+}
+
+void swap_elements(uint8_t* p, size_t elem_size, size_t bytes) {
+    for (size_t i = 0; i + elem_size <= bytes; i += elem_size) {
+        std::reverse(p + i, p + i + elem_size);
+    }
+}
+
+// 要素列を小端順のバイト列として先頭から順に fn(bytes, len) へ渡す
+template <class Fn>
+bool for_each_le_chunk(const void* data, size_t elem_size, size_t count, Fn&& fn) {
+    const uint8_t* src = (const uint8_t*)data;
+    size_t bytes = elem_size * count;
+    if (bytes == 0) return true;
+    if (elem_size == 1 || host_little_endian()) return fn(src, bytes);
+
+    std::vector<uint8_t> tmp(std::min(bytes, kSwapChunk - kSwapChunk % elem_size));
+    for (size_t pos = 0; pos < bytes; pos += tmp.size()) {
+        size_t len = std::min(tmp.size(), bytes - pos);
+        std::memcpy(tmp.data(), src + pos, len);
+        swap_elements(tmp.data(), elem_size, len);
+        if (!fn(tmp.data(), len)) return false;
+    }
+    return true;
+}
+
+/* --- META / SPARSE 区画の直列化 --- */
+
+struct ByteWriter {
+    std::vector<uint8_t> buf;
+
+    void u32(uint32_t v) {
+        uint8_t b[4];
+        ssd_store_le32(b, v);
+        buf.insert(buf.end(), b, b + 4);
+    }
+    void u64(uint64_t v) {
+        uint8_t b[8];
+        ssd_store_le64(b, v);
+        buf.insert(buf.end(), b, b + 8);
+    }
+    void i32(int32_t v) { u32((uint32_t)v); }
+    void f64(double v) {
+        uint64_t u;
+        std::memcpy(&u, &v, 8);
+        u64(u);
+    }
+    void bytes(const void* p, size_t n) {
+        buf.insert(buf.end(), (const uint8_t*)p, (const uint8_t*)p + n);
+    }
+};
+
+// 範囲外を読もうとしたら ok を落とし、以後は 0 を返す
+struct ByteReader {
+    const uint8_t* p;
+    size_t left;
+    bool ok;
+
+    ByteReader(const std::vector<uint8_t>& b) : p(b.data()), left(b.size()), ok(true) {}
+
+    const uint8_t* take(size_t n) {
+        if (!ok || left < n) {
+            ok = false;
+            return nullptr;
+        }
+        const uint8_t* r = p;
+        p += n;
+        left -= n;
+        return r;
+    }
+    uint32_t u32() {
+        const uint8_t* b = take(4);
+        return b ? ssd_load_le32(b) : 0;
+    }
+    uint64_t u64() {
+        const uint8_t* b = take(8);
+        return b ? ssd_load_le64(b) : 0;
+    }
+    int32_t i32() { return (int32_t)u32(); }
+    double f64() {
+        uint64_t u = u64();
+        double v;
+        std::memcpy(&v, &u, 8);
+        return v;
+    }
+    bool done() const { return ok && left == 0; }
+};
+
+constexpr size_t kParamCount = sizeof(SSDParams) / sizeof(double);
+static_assert(sizeof(SSDParams) == kParamCount * sizeof(double), "SSDParams は double のみで構成");
+
+std::string mt_state(const std::mt19937_64& mt) {
+    std::ostringstream os;
+    os.imbue(std::locale::classic());
+    os << mt;
+    return os.str();
+}
+
+// ハンドル作成前に読む部分（作成に必要なパラメータ・シードを含む）
+struct MetaState {
+    int32_t current;
+    double E, F, T, H, pi_sum;
+    SSDParams prm;
+    uint64_t seed, step;
+    std::string mt;
+};
+
+void write_meta(const SSDHandle* h, ByteWriter& w) {
+    w.i32(h->current);
+    w.f64(h->E);
+    w.f64(h->F);
+    w.f64(h->T);
+    w.f64(h->H);
+    w.f64(h->pi_sum);
+
+    // パラメータは宣言順の double 列（将来の追加に備えて個数付き）
+    double prm[kParamCount];
+    std::memcpy(prm, &h->prm, sizeof(SSDParams));
+    w.u32((uint32_t)kParamCount);
+    for (double v : prm) w.f64(v);
+
+    w.u64(h->rng.seed);
+    w.u64(h->rng.step);
+    std::string mt = mt_state(h->rng.mt);
+    w.u32((uint32_t)mt.size());
+    w.bytes(mt.data(), mt.size());
+}
+
+bool read_meta(ByteReader& r, MetaState* m) {
+    m->current = r.i32();
+    m->E = r.f64();
+    m->F = r.f64();
+    m->T = r.f64();
+    m->H = r.f64();
+    m->pi_sum = r.f64();
+
+    // 保存時より項目が少なければ残りは既定値、多ければ読み飛ばす
+    uint32_t count = r.u32();
+    double prm[kParamCount];
+    std::memcpy(prm, &m->prm, sizeof(SSDParams));
+    for (uint32_t i = 0; i < count && r.ok; ++i) {
+        double v = r.f64();
+        if (i < kParamCount) prm[i] = v;
+    }
+    std::memcpy(&m->prm, prm, sizeof(SSDParams));
+
+    m->seed = r.u64();
+    m->step = r.u64();
+    uint32_t len = r.u32();
+    const uint8_t* s = r.take(len);
+    if (s) m->mt.assign((const char*)s, len);
+    return r.ok;
+}
+
+// グラフ分の後の追記項目（必須）。
+// 保存元の作業スレッド数は参考情報で、読み込んだハンドルには適用しない
+bool read_meta_tail(ByteReader& r, SSDHandle* h) {
+    h->kappa_mean = r.f64();
+    r.i32();
+    return r.done();
+}
+
+template <class S>
+void write_dense_meta(const DenseGraphT<S>& g, ByteWriter& w) {
+    w.f64(g.scale);
+    w.f64(g.offset);
+    w.f64(g.sum_s);
+    w.f64(g.sum_s2);
+    w.f64(g.lo);
+    w.u32(g.lazy_steps);
+    w.u32(g.step_count);
+}
+
+template <class S>
+bool read_dense_meta(ByteReader& r, DenseGraphT<S>& g) {
+    g.scale = r.f64();
+    g.offset = r.f64();
+    g.sum_s = r.f64();
+    g.sum_s2 = r.f64();
+    g.lo = r.f64();
+    g.lazy_steps = r.u32();
+    g.step_count = r.u32();
+    return r.ok && g.scale > 0.0;
+}
+
+void write_sparse(const SparseGraph& g, ByteWriter& w) {
+    w.u64(g.touched);
+    w.u32((uint32_t)g.active_rows.size());
+    for (int32_t row : g.active_rows) w.i32(row);
+    for (const auto& row : g.rows) {
+        w.u32((uint32_t)row.size());
+        for (const SparseEdge& e : row) {
+            w.i32(e.col);
+            w.f64(e.kappa);
+            w.f64(e.w);
+            w.f64(e.j);
+        }
+    }
+    w.u64(g.runs.size());
+    for (const KappaRun& run : g.runs) {
+        w.u64(run.begin);
+        w.u64(run.end);
+        w.u64(run.untouched);
+        w.f64(run.kappa);
+        w.f64(run.j);
+    }
+}
+
+// 密行列の w（触れた経路だけを持つ間）
+template <class S>
+void write_w_edges(const DenseGraphT<S>& g, ByteWriter& w) {
+    auto edges = g.w_edges.sorted();
+    w.u64(edges.size());
+    for (const auto& e : edges) {
+        w.u64(e.first);
+        w.f64(SSDStorageTraits<S>::load(e.second));
+    }
+}
+
+template <class S>
+bool read_w_edges(ByteReader& r, DenseGraphT<S>& g) {
+    using Traits = SSDStorageTraits<S>;
+    uint64_t count = r.u64();
+    uint64_t total = (uint64_t)g.N * (uint64_t)g.N;
+    if (!r.ok || count > total || count > r.left / 16) return false;
+    for (uint64_t k = 0; k < count; ++k) {
+        uint64_t i = r.u64();
+        double v = r.f64();
+        if (i >= total) return false;
+        g.w_edges.at(i, Traits::store(0.0f, 0)) =
+            Traits::store((typename Traits::compute)v, SSD_ROUND_NEAREST);
+    }
+    return r.done();
+}
+
+bool read_sparse(ByteReader& r, SparseGraph& g) {
+    g.touched = r.u64();
+    uint32_t active = r.u32();
+    if (active > (uint32_t)g.N) return false;
+    g.active_rows.resize(active);
+    for (auto& row : g.active_rows) {
+        row = r.i32();
+        if (row < 0 || row >= g.N) return false;
+    }
+
+    for (auto& row : g.rows) {
+        uint32_t count = r.u32();
+        if (!r.ok || count > (uint32_t)g.N) return false;
+        row.resize(count);
+        for (SparseEdge& e : row) {
+            e.col = r.i32();
+            e.kappa = r.f64();
+            e.w = r.f64();
+            e.j = r.f64();
+            if (e.col < 0 || e.col >= g.N) return false;
+        }
+    }
+
+    // 区間は添字昇順で [0, N*N) を隙間なく被覆していなければならない
+    uint64_t runs = r.u64();
+    if (!r.ok || runs == 0 || runs > r.left / 40) return false;
+    g.runs.resize((size_t)runs);
+    uint64_t next = 0;
+    for (KappaRun& run : g.runs) {
+        run.begin = r.u64();
+        run.end = r.u64();
+        run.untouched = r.u64();
+        run.kappa = r.f64();
+        run.j = r.f64();
+        if (run.begin != next || run.end <= run.begin || run.untouched > run.end - run.begin) {
+            return false;
+        }
+        next = run.end;
+    }
+    return r.done() && next == g.total;
+}
+
+/* --- 区画の読み込み --- */
+
+// 区画を dst へ読み込み checksum を検査する。大端ホストでは読み込み後に要素を並べ替える
+int32_t read_section(FILE* f, const SSDStateSection& s, void* dst, size_t elem_size, size_t count) {
+    if (s.elem_size != elem_size || s.size != (uint64_t)elem_size * count) {
+        return SSD_STATE_ERR_FORMAT;
+    }
+    if (!ssd_file_seek(f, s.offset)) return SSD_STATE_ERR_IO;
+
+    uint8_t* p = (uint8_t*)dst;
+    size_t bytes = (size_t)s.size;
+    SSDChecksum sum;
+    for (size_t pos = 0; pos < bytes; pos += kIoChunk) {
+        size_t len = std::min(kIoChunk, bytes - pos);
+        if (fread(p + pos, 1, len, f) != len) return SSD_STATE_ERR_IO;
+        sum.update(p + pos, len);
+    }
+    if (sum.digest() != s.checksum) return SSD_STATE_ERR_CHECKSUM;
+
+    if (elem_size > 1 && !host_little_endian()) swap_elements(p, elem_size, bytes);
+    return SSD_STATE_OK;
+}
+
+int32_t read_section_bytes(FILE* f, const SSDStateSection& s, std::vector<uint8_t>* out) {
+    if (s.size > ((uint64_t)1 << 40)) return SSD_STATE_ERR_FORMAT;
+    try {
+        out->resize((size_t)s.size);
+    } catch (const std::bad_alloc&) {
+        return SSD_STATE_ERR_ALLOC;
+    }
+    return read_section(f, s, out->data(), 1, out->size());
+}
+
+// 1区画分の書き出し内容（elem_size 単位の要素列、ホストのバイト順）
+struct SectionData {
+    uint32_t id;
+    uint32_t elem_size;
+    const void* data;
+    size_t count;
+};
+
+int32_t load_state(FILE* f, uint64_t base, uint64_t size, SSDHandle** out) {
+    SSDStateHeader hd;
+    int32_t rc = ssd_state_read_header(f, &hd, base, size);
+    if (rc != SSD_STATE_OK) return rc;
+
+    if (hd.N <= 0 || hd.storage < SSD_STORAGE_F64 || hd.storage > SSD_STORAGE_BF16 ||
+        (hd.rng != SSD_RNG_MT19937 && hd.rng != SSD_RNG_PHILOX)) {
+        return SSD_STATE_ERR_FORMAT;
+    }
+    const SSDStateSection* meta_sec = hd.find(SSD_SECTION_META);
+    const SSDStateSection* pi_sec = hd.find(SSD_SECTION_PI);
+    if (!meta_sec || !pi_sec) return SSD_STATE_ERR_FORMAT;
+
+    std::vector<uint8_t> meta_buf;
+    rc = read_section_bytes(f, *meta_sec, &meta_buf);
+    if (rc != SSD_STATE_OK) return rc;
+    ByteReader meta(meta_buf);
+    MetaState m;
+    if (!read_meta(meta, &m) || m.current < 0 || m.current >= hd.N) return SSD_STATE_ERR_FORMAT;
+    if (hd.sparse && m.prm.eps_noise > 0.0) return SSD_STATE_ERR_FORMAT;  // 疎グラフは作成できない
+
+    SSDCreateOptions opts;
+    opts.storage = hd.storage;
+    opts.sparse = hd.sparse ? 1 : 0;
+    opts.rng = hd.rng;
+
+    std::unique_ptr<SSDHandle> h;
+    try {
+        h.reset(new SSDHandle(hd.N, m.prm, m.seed, opts));
+    } catch (const std::bad_alloc&) {
+        return SSD_STATE_ERR_ALLOC;
+    }
+    h->current = m.current;
+    h->E = m.E;
+    h->F = m.F;
+    h->T = m.T;
+    h->H = m.H;
+    h->pi_sum = m.pi_sum;
+    h->rng.step = m.step;
+    {
+        std::istringstream is(m.mt);
+        is.imbue(std::locale::classic());
+        is >> h->rng.mt;
+        if (is.fail()) return SSD_STATE_ERR_FORMAT;
+    }
+
+    rc = read_section(f, *pi_sec, h->pi.data(), sizeof(double), h->pi.size());
+    if (rc != SSD_STATE_OK) return rc;
+
+    rc = ssd_visit_graph(h.get(), [&](auto& g) -> int32_t {
+        using G = typename std::decay<decltype(g)>::type;
+        if constexpr (std::is_same<G, SparseGraph>::value) {
+            if (!read_meta_tail(meta, h.get())) return SSD_STATE_ERR_FORMAT;
+            const SSDStateSection* s = hd.find(SSD_SECTION_SPARSE);
+            if (!s) return SSD_STATE_ERR_FORMAT;
+            std::vector<uint8_t> buf;
+            int32_t r = read_section_bytes(f, *s, &buf);
+            if (r != SSD_STATE_OK) return r;
+            ByteReader reader(buf);
+            return read_sparse(reader, g) ? SSD_STATE_OK : SSD_STATE_ERR_FORMAT;
+        } else {
+            if (!read_dense_meta(meta, g) || !read_meta_tail(meta, h.get())) return SSD_STATE_ERR_FORMAT;
+            const SSDStateSection* ks = hd.find(SSD_SECTION_KAPPA);
+            const SSDStateSection* ws = hd.find(SSD_SECTION_W);
+            const SSDStateSection* es = hd.find(SSD_SECTION_W_EDGES);
+            if (!ks || !ws == !es) return SSD_STATE_ERR_FORMAT;
+            using S = typename std::decay<decltype(g.kappa[0])>::type;
+            int32_t r = read_section(f, *ks, g.kappa.data(), sizeof(S), g.kappa.size());
+            if (r != SSD_STATE_OK) return r;
+            if (es) {
+                std::vector<uint8_t> buf;
+                r = read_section_bytes(f, *es, &buf);
+                if (r != SSD_STATE_OK) return r;
+                ByteReader reader(buf);
+                return read_w_edges(reader, g) ? SSD_STATE_OK : SSD_STATE_ERR_FORMAT;
+            }
+            try {
+                g.w_dense();
+            } catch (const std::bad_alloc&) {
+                return SSD_STATE_ERR_ALLOC;
+            }
+            return read_section(f, *ws, g.w.data(), sizeof(S), g.w.size());
+        }
+    });
+    if (rc != SSD_STATE_OK) return rc;
+
+    *out = h.release();
+    return SSD_STATE_OK;
+}
+
+}  // namespace
+
+int32_t ssd_state_read_header(FILE* f, SSDStateHeader* out, uint64_t base, uint64_t size) {
+    uint64_t actual_size = size;
+    if (size == SSD_STATE_TO_END) {
+        uint64_t length;
+        if (!ssd_file_length(f, &length)) return SSD_STATE_ERR_IO;
+        if (length < base) return SSD_STATE_ERR_FORMAT;
+        actual_size = length - base;
+    }
+    if (!ssd_file_seek(f, base)) return SSD_STATE_ERR_IO;
+    if (actual_size < SSD_STATE_FIXED_HEADER) return SSD_STATE_ERR_FORMAT;
+
+    std::vector<uint8_t> head(SSD_STATE_FIXED_HEADER);
+    if (fread(head.data(), 1, head.size(), f) != head.size()) return SSD_STATE_ERR_IO;
+    if (std::memcmp(head.data(), kMagic, sizeof(kMagic)) != 0) return SSD_STATE_ERR_FORMAT;
+
+    out->version = ssd_load_le32(&head[8]);
+    out->header_size = ssd_load_le32(&head[12]);
+    out->N = (int32_t)ssd_load_le32(&head[16]);
+    out->storage = (int32_t)ssd_load_le32(&head[20]);
+    out->sparse = (int32_t)ssd_load_le32(&head[24]);
+    out->rng = (int32_t)ssd_load_le32(&head[28]);
+    uint32_t count = ssd_load_le32(&head[32]);
+    out->file_size = ssd_load_le64(&head[40]);
+    uint64_t checksum = ssd_load_le64(&head[48]);
+
+    if (out->version != SSD_STATE_VERSION || count > SSD_STATE_MAX_SECTIONS ||
+        out->header_size % SSD_STATE_ALIGN != 0 ||
+        out->header_size < SSD_STATE_FIXED_HEADER + SSD_STATE_SECTION_ENTRY * count ||
+        out->header_size > actual_size) {
+        return SSD_STATE_ERR_FORMAT;
+    }
+
+    head.resize(out->header_size);
+    size_t rest = out->header_size - SSD_STATE_FIXED_HEADER;
+    if (fread(head.data() + SSD_STATE_FIXED_HEADER, 1, rest, f) != rest) return SSD_STATE_ERR_IO;
+
+    std::memset(&head[48], 0, 8);
+    SSDChecksum sum;
+    sum.update(head.data(), head.size());
+    if (sum.digest() != checksum) return SSD_STATE_ERR_CHECKSUM;
+    if (out->file_size != actual_size) return SSD_STATE_ERR_FORMAT;  // 途中で切れている
+
+    out->sections.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* e = &head[SSD_STATE_FIXED_HEADER + SSD_STATE_SECTION_ENTRY * i];
+        SSDStateSection& s = out->sections[i];
+        s.id = ssd_load_le32(e);
+        s.elem_size = ssd_load_le32(e + 4);
+        s.offset = ssd_load_le64(e + 8);
+        s.size = ssd_load_le64(e + 16);
+        s.checksum = ssd_load_le64(e + 24);
+        if (s.elem_size == 0 || s.size % s.elem_size != 0 || s.offset % SSD_STATE_ALIGN != 0 ||
+            s.offset < out->header_size || s.offset > actual_size ||
+            s.size > actual_size - s.offset) {
+            return SSD_STATE_ERR_FORMAT;
+        }
+        s.offset += base;
+    }
+    return SSD_STATE_OK;
+}
+
+int32_t ssd_state_write(SSDHandle* h, FILE* f, uint64_t* size) {
+
+    int32_t storage = h->dense_f32 ? SSD_STORAGE_F32
+                    : h->dense_bf16 ? SSD_STORAGE_BF16 : SSD_STORAGE_F64;
+    int32_t sparse = h->sparse ? 1 : 0;
+
+    ByteWriter meta, sparse_buf;  /* sparse_buf は SPARSE または W_EDGES 区画 */
+    std::vector<SectionData> sections;
+    try {
+        write_meta(h, meta);
+        sections.push_back({SSD_SECTION_META, 1, nullptr, 0});  // 内容はグラフ分を追記してから
+        sections.push_back({SSD_SECTION_PI, sizeof(double), h->pi.data(), h->pi.size()});
+        ssd_visit_graph(h, [&](auto& g) {
+            using G = typename std::decay<decltype(g)>::type;
+            if constexpr (std::is_same<G, SparseGraph>::value) {
+                write_sparse(g, sparse_buf);
+                sections.push_back({SSD_SECTION_SPARSE, 1, sparse_buf.buf.data(), sparse_buf.buf.size()});
+            } else {
+                write_dense_meta(g, meta);
+                uint32_t elem = (uint32_t)sizeof(g.kappa[0]);
+                sections.push_back({SSD_SECTION_KAPPA, elem, g.kappa.data(), g.kappa.size()});
+                if (g.w.size()) {
+                    sections.push_back({SSD_SECTION_W, elem, g.w.data(), g.w.size()});
+                } else {
+                    write_w_edges(g, sparse_buf);
+                    sections.push_back({SSD_SECTION_W_EDGES, 1, sparse_buf.buf.data(),
+                                        sparse_buf.buf.size()});
+                }
+            }
+        });
+        // グラフ分の後の追記項目
+        meta.f64(h->kappa_mean);
+        meta.i32(h->pool ? h->pool->size() : 1);  // 保存元の作業スレッド数（参考情報）
+        sections[0].data = meta.buf.data();
+        sections[0].count = meta.buf.size();
+    } catch (const std::bad_alloc&) {
+        return SSD_STATE_ERR_ALLOC;
+    }
+
+    // 配置と checksum
+    size_t header_size = align_up(SSD_STATE_FIXED_HEADER + SSD_STATE_SECTION_ENTRY * sections.size());
+    std::vector<uint8_t> head(header_size, 0);
+    uint64_t pos = header_size;
+    for (size_t i = 0; i < sections.size(); ++i) {
+        const SectionData& d = sections[i];
+        uint64_t size = (uint64_t)d.elem_size * d.count;
+        SSDChecksum sum;
+        for_each_le_chunk(d.data, d.elem_size, d.count, [&](const uint8_t* p, size_t len) {
+            sum.update(p, len);
+            return true;
+        });
+
+        uint8_t* e = &head[SSD_STATE_FIXED_HEADER + SSD_STATE_SECTION_ENTRY * i];
+        ssd_store_le32(e, d.id);
+        ssd_store_le32(e + 4, d.elem_size);
+        ssd_store_le64(e + 8, pos);
+        ssd_store_le64(e + 16, size);
+        ssd_store_le64(e + 24, sum.digest());
+        pos = align_up((size_t)(pos + size));
+    }
+    uint64_t file_size = pos;
+    if (size) *size = file_size;
+
+    std::memcpy(head.data(), kMagic, sizeof(kMagic));
+    ssd_store_le32(&head[8], SSD_STATE_VERSION);
+    ssd_store_le32(&head[12], (uint32_t)header_size);
+    ssd_store_le32(&head[16], (uint32_t)h->N);
+    ssd_store_le32(&head[20], (uint32_t)storage);
+    ssd_store_le32(&head[24], (uint32_t)sparse);
+    ssd_store_le32(&head[28], (uint32_t)h->rng.kind);
+    ssd_store_le32(&head[32], (uint32_t)sections.size());
+    ssd_store_le64(&head[40], file_size);
+    SSDChecksum head_sum;
+    head_sum.update(head.data(), head.size());
+    ssd_store_le64(&head[48], head_sum.digest());
+
+    static const uint8_t zeros[SSD_STATE_ALIGN] = {};
+    bool ok = fwrite(head.data(), 1, head.size(), f) == head.size();
+    pos = header_size;
+    for (const SectionData& d : sections) {
+        if (!ok) break;
+        ok = for_each_le_chunk(d.data, d.elem_size, d.count, [&](const uint8_t* p, size_t len) {
+            return fwrite(p, 1, len, f) == len;
+        });
+        pos += (uint64_t)d.elem_size * d.count;
+        size_t pad = (size_t)(align_up((size_t)pos) - pos);
+        if (ok && pad > 0) ok = fwrite(zeros, 1, pad, f) == pad;
+        pos += pad;
+    }
+    return ok ? SSD_STATE_OK : SSD_STATE_ERR_IO;
+}
+
+int32_t ssd_state_load(FILE* f, uint64_t base, uint64_t size, SSDHandle** out) {
+    return load_state(f, base, size, out);
+}
+
+extern "C" int32_t ssd_save_state(SSDHandle* h, const char* path) {
+    if (!h || !path) return SSD_STATE_ERR_ARG;
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return SSD_STATE_ERR_IO;
+    int32_t rc = ssd_state_write(h, f, nullptr);
+    if (fclose(f) != 0 && rc == SSD_STATE_OK) rc = SSD_STATE_ERR_IO;
+    return rc;
+}
+
+extern "C" SSDHandle* ssd_load_state(const char* path, int32_t* err) {
+    int32_t rc = SSD_STATE_ERR_ARG;
+    SSDHandle* h = nullptr;
+    if (path) {
+        FILE* f = fopen(path, "rb");
+        if (f) {
+            rc = load_state(f, 0, SSD_STATE_TO_END, &h);
+            fclose(f);
+        } else {
+            rc = SSD_STATE_ERR_IO;
+        }
+    }
+    if (err) *err = rc;
+    return h;
+}
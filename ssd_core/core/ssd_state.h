@@ -0,0 +1,228 @@
+﻿#pragma once
+#include "ssd_core.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+// 状態ファイル形式（非公開、ssd_save_state / ssd_load_state）
+//
+// すべて小端順。固定ヘッダ（64B）＋区画表（32B × 区画数）の後に各区画を
+// 64B 境界で並べる。kappa / w 区画は格納値の生配列なので、ファイルを mmap して
+// そのまま行列として参照できる（w が触れた経路だけの間は W の代わりに W_EDGES）。各区画とヘッダ（checksum 欄を0としたもの＋区画表）は
+// XXH64 で検査する。
+//
+//   0  char     magic[8]      "SSDSTATE"
+//   8  u32      version
+//  12  u32      header_size   ヘッダ＋区画表（64 の倍数）
+//  16  i32      N
+//  20  i32      storage       SSD_STORAGE_*
+//  24  i32      sparse
+//  28  i32      rng           SSD_RNG_*
+//  32  u32      section_count
+//  36  u32      reserved
+//  40  u64      file_size
+//  48  u64      checksum
+//  56  u64      reserved
+//  区画表: u32 id, u32 elem_size, u64 offset, u64 size, u64 checksum
+//
+// META 区画（すべての項目が必須、余りや不足は形式エラー）:
+//   i32 current, f64 E, F, T, H, pi_sum
+//   u32 param_count, f64 × param_count   SSDParams の宣言順（多ければ読み飛ばし、少なければ既定値）
+//   u64 seed, u64 step, u32 len, char[len]  乱数の鍵・カウンタと mt19937_64 の状態文字列
+//   密行列のみ: f64 scale, offset, sum_s, sum_s2, lo, u32 lazy_steps, step_count
+//   f64 kappa_mean
+//   i32 threads   保存元の作業スレッド数（参考情報、読み込み時には適用しない）
+
+constexpr uint32_t SSD_STATE_VERSION = 1;
+constexpr size_t SSD_STATE_ALIGN = 64;
+constexpr size_t SSD_STATE_FIXED_HEADER = 64;
+constexpr size_t SSD_STATE_SECTION_ENTRY = 32;
+constexpr uint32_t SSD_STATE_MAX_SECTIONS = 16;
+
+enum : uint32_t {
+    SSD_SECTION_META = 1,    /* スカラー状態・パラメータ・乱数状態 */
+    SSD_SECTION_PI = 2,      /* 跳躍方策の未正規化重み（double × N） */
+    SSD_SECTION_KAPPA = 3,   /* 密行列 kappa 格納値（elem_size = 格納型） */
+    SSD_SECTION_W = 4,       /* 密行列 w 格納値 */
+    SSD_SECTION_SPARSE = 5,  /* 疎グラフ（接触経路・区間） */
+    SSD_SECTION_W_EDGES = 6, /* 密行列 w の接触経路（u64 件数, {u64 添字, f64 値} × 件数、W と排他） */
+};
+
+struct SSDStateSection {
+    uint32_t id;
+    uint32_t elem_size;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t checksum;
+};
+
+struct SSDStateHeader {
+    uint32_t version;
+    uint32_t header_size;
+    int32_t N;
+    int32_t storage;
+    int32_t sparse;
+    int32_t rng;
+    uint64_t file_size;
+    std::vector<SSDStateSection> sections;
+
+    const SSDStateSection* find(uint32_t id) const {
+        for (const auto& s : sections) {
+            if (s.id == id) return &s;
+        }
+        return nullptr;
+    }
+};
+
+// 状態の像はファイル内の任意の位置に置ける（区画の offset は像の先頭から）。
+// size に渡すと「ファイル末尾まで」
+constexpr uint64_t SSD_STATE_TO_END = ~(uint64_t)0;
+
+// f の base から size バイトの像のヘッダと区画表を読み、形式・ヘッダ checksum・区画の範囲を
+// 検査する（区画本体は読まない）。区画の offset はファイル先頭からの位置に直して返す。
+// 戻り値は SSD_STATE_OK または SSD_STATE_ERR_*
+int32_t ssd_state_read_header(FILE* f, SSDStateHeader* out, uint64_t base = 0,
+                              uint64_t size = SSD_STATE_TO_END);
+
+// h の状態の像を f の現在位置から順に書き出し、バイト数を size へ返す（NULL 可、シークしない）
+int32_t ssd_state_write(SSDHandle* h, FILE* f, uint64_t* size);
+// f の base から size バイトの像から新しいハンドルを作る
+int32_t ssd_state_load(FILE* f, uint64_t base, uint64_t size, SSDHandle** out);
+
+/* --- 64bit のファイル位置 --- */
+
+static inline bool ssd_file_seek(FILE* f, uint64_t pos) {
+#ifdef _WIN32
+    return _fseeki64(f, (__int64)pos, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)pos, SEEK_SET) == 0;
+#endif
+}
+
+static inline bool ssd_file_tell(FILE* f, uint64_t* out) {
+#ifdef _WIN32
+    __int64 n = _ftelli64(f);
+#else
+    off_t n = ftello(f);
+#endif
+    if (n < 0) return false;
+    *out = (uint64_t)n;
+    return true;
+}
+
+// 末尾へ移動して長さを返す
+static inline bool ssd_file_length(FILE* f, uint64_t* out) {
+#ifdef _WIN32
+    if (_fseeki64(f, 0, SEEK_END) != 0) return false;
+#else
+    if (fseeko(f, 0, SEEK_END) != 0) return false;
+#endif
+    return ssd_file_tell(f, out);
+}
+
+/* --- 小端順の読み書き --- */
+
+static inline uint32_t ssd_load_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline uint64_t ssd_load_le64(const uint8_t* p) {
+    return (uint64_t)ssd_load_le32(p) | (uint64_t)ssd_load_le32(p + 4) << 32;
+}
+
+static inline void ssd_store_le32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline void ssd_store_le64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+/* --- XXH64（逐次入力版） --- */
+
+struct SSDChecksum {
+    static constexpr uint64_t P1 = 11400714785074694791ULL;
+    static constexpr uint64_t P2 = 14029467366897019727ULL;
+    static constexpr uint64_t P3 = 1609587929392839161ULL;
+    static constexpr uint64_t P4 = 9650029242287828579ULL;
+    static constexpr uint64_t P5 = 2870177450012600261ULL;
+
+    uint64_t v[4];
+    uint64_t seed;
+    uint64_t total;
+    uint8_t buf[32];
+    size_t buf_len;
+
+    explicit SSDChecksum(uint64_t s = 0)
+        : v{s + P1 + P2, s + P2, s, s - P1}, seed(s), total(0), buf_len(0) {}
+
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    static uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * P2;
+        return rotl(acc, 31) * P1;
+    }
+    static uint64_t merge(uint64_t acc, uint64_t val) {
+        acc ^= round(0, val);
+        return acc * P1 + P4;
+    }
+
+    void stripe(const uint8_t* p) {
+        for (int i = 0; i < 4; ++i) v[i] = round(v[i], ssd_load_le64(p + 8 * i));
+    }
+
+    void update(const void* data, size_t len) {
+        const uint8_t* p = (const uint8_t*)data;
+        total += len;
+        if (buf_len > 0) {
+            size_t take = 32 - buf_len < len ? 32 - buf_len : len;
+            for (size_t i = 0; i < take; ++i) buf[buf_len + i] = p[i];
+            buf_len += take;
+            p += take;
+            len -= take;
+            if (buf_len < 32) return;
+            stripe(buf);
+            buf_len = 0;
+        }
+        for (; len >= 32; p += 32, len -= 32) stripe(p);
+        for (size_t i = 0; i < len; ++i) buf[i] = p[i];
+        buf_len = len;
+    }
+
+    uint64_t digest() const {
+        uint64_t h;
+        if (total >= 32) {
+            h = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18);
+            for (int i = 0; i < 4; ++i) h = merge(h, v[i]);
+        } else {
+            h = seed + P5;
+        }
+        h += total;
+
+        const uint8_t* p = buf;
+        size_t len = buf_len;
+        for (; len >= 8; p += 8, len -= 8) {
+            h ^= round(0, ssd_load_le64(p));
+            h = rotl(h, 27) * P1 + P4;
+        }
+        if (len >= 4) {
+            h ^= (uint64_t)ssd_load_le32(p) * P1;
+            h = rotl(h, 23) * P2 + P3;
+            p += 4;
+            len -= 4;
+        }
+        for (; len > 0; ++p, --len) {
+            h ^= *p * P5;
+            h = rotl(h, 11) * P1;
+        }
+
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+};
@@ -0,0 +1,242 @@
+﻿#pragma once
+#include "ssd_handle.h"
+
+#include <cmath>
+
+// ssd_step 本体（非公開）。グラフ表現（密/疎/アンサンブル）に依らない1本のアルゴリズムで、
+// Graph は以下を提供する:
+//   AlignKernelResult align_update(SSDHandle&, double p, double dt)  // 1+2（ssd_step_impl のみ）
+//   void row_values(int row, double* out, int len) const
+//   void copy_block(int row0, int col0, int nrows, int ncols, double* out) const  // ssd_copy_kappa_block
+//   void add_edge(int row, int col, double d_kappa, double d_w)
+//   void relax_top(size_t count, double eps, double kappa_min)
+//   int argmax_row(int row) const
+
+/* --- ヘルパー関数 --- */
+static inline double clip(double x, double lo, double hi) {
+    return x < lo ? lo : (x > hi ? hi : x);
+}
+
+// 温度付きソフトマックスを正規化せずに求める。out[i] = exp((logits[i] - max) / T)、
+// 戻り値は Σout と正規化エントロピー。エントロピーは H = log Z - Σ w z / Z として
+// 同じパスで集計するので、確率の正規化パスも要素ごとの log も要らない
+struct SoftmaxWeights {
+    double sum;
+    double entropy;
+};
+
+static inline SoftmaxWeights softmax_weights(const double* logits, int n, double T, double* out) {
+    if (n == 0) return {1.0, 0.0};
+
+    if (T <= 1e-8) {
+        // argmax one-hot
+        int arg = 0;
+        for (int i = 1; i < n; ++i) {
+            if (logits[i] > logits[arg]) arg = i;
+        }
+        std::fill(out, out + n, 0.0);
+        out[arg] = 1.0;
+        return {1.0, 0.0};
+    }
+
+    // 数値安定化のため最大値を引く
+    double maxv = *std::max_element(logits, logits + n);
+
+    double sum = 0.0, sum_wz = 0.0;
+    for (int i = 0; i < n; ++i) {
+        double z = (logits[i] - maxv) / T;
+        double e = std::exp(z);
+        out[i] = e;
+        sum += e;
+        sum_wz += e * z;
+    }
+
+    // 最大要素の重みは1なので sum >= 1
+    double H = std::log(sum) - sum_wz / sum;
+    double Hmax = std::log((double)n);
+    return {sum, Hmax > 0.0 ? clip(H / Hmax, 0.0, 1.0) : 0.0};
+}
+
+static inline double entropy_norm(const double* p, int n) {
+    if (n == 0) return 0.0;
+
+    double H = 0.0;
+    for (int i = 0; i < n; ++i) {
+        double x = p[i] <= 1e-12 ? 1e-12 : p[i];
+        H += -x * std::log(x);
+    }
+
+    double Hmax = std::log((double)n);
+    return Hmax > 0.0 ? (H / Hmax) : 0.0;
+}
+
+// RelaxTop 対象数: round(q * 全経路数) を [1, 全経路数] に収める
+static inline size_t relax_count_for(double q_relax, size_t total_edges) {
+    double q_count = std::round(q_relax * (double)total_edges);
+    if (q_count < 1.0) return 1;
+    if (q_count >= (double)total_edges) return total_edges;
+    return (size_t)q_count;
+}
+
+// 1ステップ分の可変状態（SSDHandle / アンサンブルの1メンバーを同じ形で参照する）
+struct SSDStepState {
+    int N;
+    int& current;
+    double& E;
+    double& F;
+    double& T;
+    double& H;       /* pi の正規化エントロピー（キャッシュ） */
+    double& pi_sum;  /* pi の総和（pi は跳躍方策の未正規化重み） */
+    const SSDParams& prm;
+    SSDRandom& rng;
+    double* pi;      /* size N（確率は pi[k] / pi_sum） */
+    double* logits;  /* size N スクラッチ */
+};
+
+// 3〜6（熱・閾値・跳躍・テレメトリ）。fused は 1+2 の結果
+template <class Graph>
+void ssd_step_finish(SSDStepState* h, Graph& graph, const AlignKernelResult& fused,
+                     double p, double dt, SSDTelemetry* out) {
+    int N = h->N;
+    auto& prm = h->prm;
+
+    double J_norm = std::sqrt(fused.J_sq);
+
+    // === 3. UpdateHeat（熱蓄積更新） ===
+    double excess_pressure = std::max(std::abs(p) - J_norm, 0.0);
+    double dE = prm.alpha * excess_pressure - prm.beta_E * h->E;
+    h->E = std::max(h->E + dE * dt, 0.0);
+
+    // === 4. Threshold / JumpRate / Temperature ===
+    // 平均慣性（融合カーネルの総和から）
+    double kappa_mean = fused.kappa_sum / ((double)N * (double)N);
+
+    // 動的閾値
+    double Theta = prm.Theta0 + prm.a1 * kappa_mean - prm.a2 * h->F;
+
+    // 跳躍率（ポアソン過程）
+    double hrate = prm.h0 * std::exp((h->E - Theta) / std::max(1e-8, prm.gamma));
+
+    // 探索温度（硬直検知付き）。pi は跳躍時しか変わらないのでエントロピーはキャッシュ値
+    double policy_entropy = h->H;
+    h->T = std::max(1e-6, prm.T0 + prm.c1 * h->E - prm.c2 * policy_entropy);
+
+    // === 5. 跳躍判定と実行 ===
+    bool did_jump = false;
+    int rewired_to = h->current;
+
+    double jump_probability = 1.0 - std::exp(-hrate * dt);
+    if (h->rng.uniform(0) < jump_probability) {
+        did_jump = true;
+
+        // === 制約付きランダム接続 ===
+        // 現在ノードから他のノードへの接続確率を計算
+        double* logits = h->logits;
+        // 既存の慣性をベースとする
+        graph.row_values(h->current, logits, N);
+        // ガウスノイズは一括生成（pi は直後のソフトマックスで上書きするので一時領域に使う）
+        double* noise = h->pi;
+        h->rng.fill_logit_noise(noise, N);
+        for (int k = 0; k < N; ++k) {
+            // 自己接続を抑制
+            if (k == h->current) {
+                logits[k] -= 1.0;
+            }
+
+            // ガウスノイズ追加
+            logits[k] += prm.sigma * noise[k];
+        }
+
+        // ソフトマックスの重み（正規化はしない）とエントロピー
+        SoftmaxWeights sw = softmax_weights(logits, N, h->T, h->pi);
+        h->pi_sum = sw.sum;
+        h->H = sw.entropy;
+
+        // カテゴリカル分布からサンプリング（未正規化の累積和を r*Σw と比べる）
+        double target = h->rng.uniform(1) * sw.sum;
+        double cdf = 0.0;
+        int selected = N - 1;  // フォールバック
+        for (int k = 0; k < N; ++k) {
+            cdf += h->pi[k];
+            if (target <= cdf) {
+                selected = k;
+                break;
+            }
+        }
+
+        // === Rewire（再配線） ===
+        graph.add_edge(h->current, selected, prm.delta_kappa, prm.delta_w);
+
+        // 放熱
+        h->E *= prm.c0_cool;
+
+        // 位置更新
+        h->current = selected;
+        rewired_to = selected;
+
+        // === RelaxTop（硬直ほぐし） ===
+        // |j| 上位q%の経路を微緩和（同値は添字の小さい順）
+        size_t total_edges = (size_t)N * N;
+        graph.relax_top(relax_count_for(prm.q_relax, total_edges), prm.eps_relax, prm.kappa_min);
+
+    } else {
+        // === ε-greedy完全ランダム探索 ===
+        double eps = prm.eps0 + prm.d1 * h->E - prm.d2 * kappa_mean;
+        eps = clip(eps, 0.0, 1.0);
+
+        if (h->rng.uniform(2) < eps) {
+            int k = (int)std::floor(h->rng.uniform(3) * N);
+            if (k == N) k = N - 1;
+
+            if (k != h->current) {
+                // 小さな慣性・重み追加
+                graph.add_edge(h->current, k, 0.05, 0.05);
+            }
+        }
+
+        // === 決定論的行動選択 ===
+        // 現在位置から最も慣性の高い接続先を選択
+        int best = graph.argmax_row(h->current);
+
+        h->current = best;
+        rewired_to = best;
+    }
+
+    // === 6. テレメトリ出力 ===
+    if (out) {
+        double align_efficiency = (std::abs(p) > 1e-8) ? (J_norm / std::abs(p)) : 0.0;
+
+        out->E = h->E;
+        out->Theta = Theta;
+        out->h = hrate;
+        out->T = h->T;
+        out->H = policy_entropy;
+        out->J_norm = J_norm;
+        out->align_eff = align_efficiency;
+        out->kappa_mean = kappa_mean;
+        out->current = h->current;
+        out->did_jump = did_jump ? 1 : 0;
+        out->rewired_to = rewired_to;
+    }
+}
+
+template <class Graph>
+void ssd_step_impl(SSDHandle* h, Graph& graph, double p, double dt, SSDTelemetry* out) {
+    if (h->recorder) h->recorder->before_step(h, p, dt);
+
+    // === 1+2. AlignFlow + UpdateKappa（整合流計算・整合慣性更新） ===
+    // j = (G0 + g*kappa) * p + noise
+    // kappa += (eta*(p*j - rho*j^2) - lam*(kappa - kappa_min)) * dt
+    AlignKernelResult fused = graph.align_update(*h, p, dt);
+
+    SSDStepState s{h->N, h->current, h->E, h->F, h->T, h->H, h->pi_sum, h->prm, h->rng,
+                   h->pi.data(), h->logits.data()};
+    // リングがあれば out の有無に関わらず毎ステップのテレメトリを積む
+    SSDTelemetry local;
+    SSDTelemetry* tel = out ? out : (h->ring ? &local : nullptr);
+    ssd_step_finish(&s, graph, fused, p, dt, tel);
+    h->kappa_mean = fused.kappa_sum / ((double)h->N * (double)h->N);  // テレメトリと同じ式
+    if (h->ring) h->ring->push(*tel);
+    h->rng.step++;
+    h->generation++;
+}
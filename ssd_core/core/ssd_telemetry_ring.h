@@ -0,0 +1,58 @@
+﻿#pragma once
+#include "ssd_core.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+// ステップごとのテレメトリを溜める固定容量リング（非公開、SSDCreateOptions::telemetry_ring）
+//
+// 生産者はステップを進めるスレッド1本、消費者は ssd_drain_telemetry を呼ぶスレッド1本。
+// ロックは使わず、各添字は一方のスレッドだけが書く。生産者は消費者の添字を手元に
+// 写しておき、満杯に見えたときだけ読み直すので、通常のステップで触れる共有変数は
+// 自分の head への release ストア1回だけ。満杯なら新しい記録を捨てて数える（待たない）。
+struct SSDTelemetryRing {
+    std::vector<SSDTelemetry> slots;  /* 容量（2の冪） */
+    uint64_t mask;
+
+    alignas(64) std::atomic<uint64_t> head;     /* 書き込み済み件数（生産者のみ書く） */
+    uint64_t tail_cache;                        /* 生産者が最後に見た tail */
+    std::atomic<uint64_t> dropped;              /* 満杯で捨てた件数（生産者のみ書く） */
+    alignas(64) std::atomic<uint64_t> tail;     /* 読み出し済み件数（消費者のみ書く） */
+
+    explicit SSDTelemetryRing(size_t capacity)
+        : slots(round_up(capacity)), mask(slots.size() - 1), head(0), tail_cache(0), dropped(0),
+          tail(0) {}
+
+    static size_t round_up(size_t n) {
+        size_t c = 1;
+        while (c < n) c <<= 1;
+        return c;
+    }
+
+    // 生産者
+    void push(const SSDTelemetry& t) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail_cache >= slots.size()) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h - tail_cache >= slots.size()) {
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        slots[h & mask] = t;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // 消費者: 古い順に最大 max 件を out へ取り出す
+    size_t drain(SSDTelemetry* out, size_t max) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        size_t n = (size_t)(h - t) < max ? (size_t)(h - t) : max;
+        for (size_t k = 0; k < n; ++k) out[k] = slots[(t + k) & mask];
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+};
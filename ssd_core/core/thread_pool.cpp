@@ -0,0 +1,83 @@
+﻿#include "thread_pool.h"
+
+#include <algorithm>
+
+SSDThreadPool::SSDThreadPool(int threads)
+    : job_(nullptr), count_(0), parts_(0), generation_(0), pending_(0), stop_(false) {
+    if (threads <= 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    workers_.reserve(threads - 1);
+    for (int w = 1; w < threads; ++w) {
+        workers_.emplace_back(&SSDThreadPool::worker_loop, this, w);
+    }
+}
+
+SSDThreadPool::~SSDThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : workers_) t.join();
+}
+
+// 作業者 part が担当する区間
+static inline void part_range(size_t count, int parts, int part, size_t* begin, size_t* end) {
+    *begin = count * (size_t)part / (size_t)parts;
+    *end = count * (size_t)(part + 1) / (size_t)parts;
+}
+
+void SSDThreadPool::parallel_for(size_t count, const std::function<void(size_t, size_t, int)>& fn) {
+    if (count == 0) return;
+
+    int parts = (int)std::min<size_t>((size_t)size(), count);
+    if (parts == 1) {
+        fn(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &fn;
+        count_ = count;
+        parts_ = parts;
+        pending_ = parts - 1;
+        generation_++;
+    }
+    wake_.notify_all();
+
+    size_t begin, end;
+    part_range(count, parts, 0, &begin, &end);
+    fn(begin, end, 0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+    job_ = nullptr;
+}
+
+void SSDThreadPool::worker_loop(int worker) {
+    unsigned seen = 0;
+    for (;;) {
+        const std::function<void(size_t, size_t, int)>* job;
+        size_t count;
+        int parts;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            if (worker >= parts_) continue;  // 今回は担当区間なし
+            job = job_;
+            count = count_;
+            parts = parts_;
+        }
+
+        size_t begin, end;
+        part_range(count, parts, worker, &begin, &end);
+        (*job)(begin, end, worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_ == 0) done_.notify_one();
+        }
+    }
+}
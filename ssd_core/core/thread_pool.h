@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <stddef.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定サイズのスレッドプール（非公開）
+//
+// parallel_for は [0, count) を作業者数で等分した連続区間に分け、呼び出しスレッドを
+// 作業者0として全区間の完了まで待つ。区間割り当ては count と作業者数だけで決まる。
+class SSDThreadPool {
+public:
+    // threads <= 0 ならハードウェアスレッド数
+    explicit SSDThreadPool(int threads);
+    ~SSDThreadPool();
+
+    SSDThreadPool(const SSDThreadPool&) = delete;
+    SSDThreadPool& operator=(const SSDThreadPool&) = delete;
+
+    int size() const { return (int)workers_.size() + 1; }
+
+    // fn(begin, end, worker)。worker は 0..size()-1（作業者ごとのスクラッチ選択用）
+    void parallel_for(size_t count, const std::function<void(size_t, size_t, int)>& fn);
+
+private:
+    void worker_loop(int worker);
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    const std::function<void(size_t, size_t, int)>* job_;
+    size_t count_;
+    int parts_;
+    unsigned generation_;
+    int pending_;
+    bool stop_;
+};
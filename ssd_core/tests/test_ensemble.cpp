@@ -0,0 +1,172 @@
+﻿/*
+ * test_ensemble.cpp
+ * ssd_ensemble の各メンバーと単独ハンドル（ssd_create）の一致検証
+ */
+
+#include "core/ssd_core.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static bool close_rel(double a, double b, double tol) {
+    return std::abs(a - b) <= tol * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+}
+
+static bool same_telemetry(const SSDTelemetry& a, const SSDTelemetry& b) {
+    const double tol = 1e-9;
+    return a.current == b.current && a.did_jump == b.did_jump && a.rewired_to == b.rewired_to &&
+           close_rel(a.E, b.E, tol) && close_rel(a.Theta, b.Theta, tol) &&
+           close_rel(a.h, b.h, tol) && close_rel(a.T, b.T, tol) && close_rel(a.H, b.H, tol) &&
+           close_rel(a.J_norm, b.J_norm, tol) && close_rel(a.align_eff, b.align_eff, tol) &&
+           close_rel(a.kappa_mean, b.kappa_mean, tol);
+}
+
+static double member_pressure(int m, int t) {
+    return 1.0 + 0.5 * std::sin(t * 0.07 + m) + ((t / 30 + m) % 3 == 0 ? 2.0 : 0.0);
+}
+
+int run_vs_handles(const char* name, int M, int N, const SSDParams& params, int steps, int threads) {
+    print_test_header(name);
+
+    const uint64_t seed = 4242;
+    SSDEnsemble* ens = ssd_ensemble_create(M, N, &params, seed);
+    if (!ens) {
+        std::cout << "ERROR: Failed to create ensemble" << std::endl;
+        return 1;
+    }
+    ssd_ensemble_set_threads(ens, threads);
+
+    std::vector<SSDHandle*> handles(M);
+    for (int m = 0; m < M; ++m) {
+        handles[m] = ssd_create(N, &params, ssd_ensemble_member_seed(seed, m));
+    }
+
+    int jumps = 0;
+    int failed_step = -1;
+    std::vector<double> p(M);
+    std::vector<SSDTelemetry> out(M);
+    std::vector<double> row_e(N), row_h(N);
+    for (int t = 0; t < steps && failed_step < 0; ++t) {
+        for (int m = 0; m < M; ++m) p[m] = member_pressure(m, t);
+        ssd_ensemble_step(ens, p.data(), 0.1, out.data());
+
+        for (int m = 0; m < M && failed_step < 0; ++m) {
+            SSDTelemetry tel;
+            ssd_step(handles[m], p[m], 0.1, &tel);
+            jumps += tel.did_jump;
+            if (!same_telemetry(out[m], tel)) failed_step = t;
+        }
+
+        // 定期的に全メンバーの全行を比較
+        if (t % 50 == 0) {
+            for (int m = 0; m < M && failed_step < 0; ++m) {
+                for (int r = 0; r < N && failed_step < 0; ++r) {
+                    ssd_ensemble_get_kappa_row(ens, m, r, row_e.data(), N);
+                    ssd_get_kappa_row(handles[m], r, row_h.data(), N);
+                    for (int c = 0; c < N; ++c) {
+                        if (!close_rel(row_e[c], row_h[c], 1e-9)) failed_step = t;
+                    }
+                }
+            }
+        }
+    }
+
+    for (SSDHandle* h : handles) ssd_destroy(h);
+    ssd_ensemble_destroy(ens);
+
+    std::cout << "M: " << M << ", N: " << N << ", threads: " << threads
+              << ", steps: " << steps << ", jumps: " << jumps << std::endl;
+    if (failed_step >= 0) {
+        std::cout << "ERROR: ensemble/handle diverged at step " << failed_step << std::endl;
+        return 1;
+    }
+    std::cout << "Every member matches its standalone handle" << std::endl;
+    return 0;
+}
+
+// スレッド数を変えても出力がビット一致すること
+int run_thread_invariance(int M, int N, const SSDParams& params, int steps) {
+    print_test_header("Thread Count Invariance");
+
+    SSDEnsemble* single = ssd_ensemble_create(M, N, &params, 9);
+    SSDEnsemble* multi = ssd_ensemble_create(M, N, &params, 9);
+    if (!single || !multi) {
+        std::cout << "ERROR: Failed to create ensembles" << std::endl;
+        ssd_ensemble_destroy(single);
+        ssd_ensemble_destroy(multi);
+        return 1;
+    }
+    ssd_ensemble_set_threads(single, 1);
+    ssd_ensemble_set_threads(multi, 4);
+
+    bool ok = true;
+    std::vector<double> p(M);
+    std::vector<SSDTelemetry> out_s(M), out_m(M);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int t = 0; t < steps && ok; ++t) {
+        for (int m = 0; m < M; ++m) p[m] = member_pressure(m, t);
+        ssd_ensemble_step(single, p.data(), 0.1, out_s.data());
+        ssd_ensemble_step(multi, p.data(), 0.1, out_m.data());
+        ok = std::memcmp(out_s.data(), out_m.data(), sizeof(SSDTelemetry) * M) == 0;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    ssd_ensemble_destroy(single);
+    ssd_ensemble_destroy(multi);
+
+    double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / steps;
+    std::cout << "M: " << M << ", N: " << N << ", " << ms << " ms per step pair" << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: telemetry depends on thread count" << std::endl;
+        return 1;
+    }
+    std::cout << "1 and 4 threads produce identical telemetry" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Ensemble Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    // ノイズありの跳躍の多い設定（単独ハンドルも通常経路で更新される）
+    SSDParams jumpy{};
+    jumpy.G0 = 0.01;
+    jumpy.g = 0.02;
+    jumpy.h0 = 5.0;
+    jumpy.eps0 = 0.3;
+    jumpy.eps_noise = 0.02;
+    jumpy.q_relax = 0.17;
+
+    total_tests++;
+    if (run_vs_handles("Members vs Handles (1 thread)", 37, 9, jumpy, 300, 1) == 0) passed_tests++;
+    total_tests++;
+    if (run_vs_handles("Members vs Handles (3 threads)", 150, 6, jumpy, 200, 3) == 0) passed_tests++;
+
+    total_tests++;
+    if (run_thread_invariance(4000, 8, jumpy, 50) == 0) passed_tests++;
+
+    // 不正な引数
+    print_test_header("Invalid Arguments");
+    total_tests++;
+    if (!ssd_ensemble_create(0, 8, nullptr, 1) && !ssd_ensemble_create(4, 0, nullptr, 1) &&
+        ssd_ensemble_get_M(nullptr) == 0) {
+        std::cout << "Invalid arguments rejected" << std::endl;
+        passed_tests++;
+    } else {
+        std::cout << "ERROR: invalid arguments accepted" << std::endl;
+    }
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+﻿/*
+ * test_jump_policy.cpp
+ * 跳躍方策（未正規化ソフトマックス重み＋同一パスのエントロピー）と正規化版の一致検証
+ */
+
+#include "core/ssd_step_impl.h"
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <chrono>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+// 従来の手順: 正規化した確率を作り、要素ごとの log でエントロピーを取る
+static double reference_policy(const double* logits, int n, double T, double* prob) {
+    double maxv = *std::max_element(logits, logits + n);
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i) {
+        prob[i] = std::exp((logits[i] - maxv) / T);
+        sum += prob[i];
+    }
+    for (int i = 0; i < n; ++i) prob[i] /= sum;
+    return entropy_norm(prob, n);
+}
+
+int test_against_reference() {
+    print_test_header("Weights and Entropy vs Normalized Softmax");
+
+    std::mt19937_64 rng(17);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    const int sizes[] = {2, 3, 17, 256, 4099};
+    const double temps[] = {1e-3, 0.05, 0.3, 1.0, 25.0};
+
+    double max_prob_err = 0.0, max_h_err = 0.0;
+    for (int n : sizes) {
+        std::vector<double> logits(n), w(n), prob(n);
+        for (double T : temps) {
+            for (int k = 0; k < n; ++k) logits[k] = 3.0 * normal(rng);
+            double H_ref = reference_policy(logits.data(), n, T, prob.data());
+            SoftmaxWeights sw = softmax_weights(logits.data(), n, T, w.data());
+            for (int k = 0; k < n; ++k) {
+                max_prob_err = std::max(max_prob_err, std::abs(w[k] / sw.sum - prob[k]));
+            }
+            // 参照側は p < 1e-12 を 1e-12 に切り上げるので、その分（最大 n 要素）を差し引く
+            double clamp_bias = n * 1e-12 * -std::log(1e-12) / std::log((double)n);
+            max_h_err = std::max(max_h_err, std::abs(sw.entropy - H_ref) - clamp_bias);
+        }
+    }
+
+    std::cout << "max |p - p_ref|: " << max_prob_err << ", max |H - H_ref|: " << max_h_err
+              << std::endl;
+    if (max_prob_err > 1e-14 || max_h_err > 1e-12) {
+        std::cout << "ERROR: policy differs from the normalized softmax" << std::endl;
+        return 1;
+    }
+    std::cout << "Unnormalized weights reproduce the policy and its entropy" << std::endl;
+    return 0;
+}
+
+// 一様・一点集中の端点
+int test_edge_cases() {
+    print_test_header("Uniform and Peaked Policies");
+
+    const int n = 64;
+    std::vector<double> logits(n, 0.5), w(n);
+    SoftmaxWeights uniform = softmax_weights(logits.data(), n, 0.7, w.data());
+    logits[5] = 1e4;
+    SoftmaxWeights peaked = softmax_weights(logits.data(), n, 0.7, w.data());
+
+    std::cout << "uniform H: " << uniform.entropy << ", peaked H: " << peaked.entropy
+              << ", peaked sum: " << peaked.sum << std::endl;
+    if (std::abs(uniform.entropy - 1.0) > 1e-12 || uniform.sum != n || peaked.entropy != 0.0 ||
+        peaked.sum != 1.0 || w[5] != 1.0) {
+        std::cout << "ERROR: unexpected entropy at the extremes" << std::endl;
+        return 1;
+    }
+    std::cout << "Extremes give H=1 and H=0" << std::endl;
+    return 0;
+}
+
+// 高温での方策計算コスト（参考値の表示のみ）
+int report_cost() {
+    print_test_header("Policy Cost");
+
+    const int n = 4096;
+    const int reps = 200;
+    std::mt19937_64 rng(3);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::vector<double> logits(n), w(n), prob(n);
+    for (int k = 0; k < n; ++k) logits[k] = normal(rng);
+
+    double sink = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) sink += reference_policy(logits.data(), n, 5.0, prob.data());
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) sink += softmax_weights(logits.data(), n, 5.0, w.data()).entropy;
+    auto t2 = std::chrono::steady_clock::now();
+
+    double us_ref = std::chrono::duration<double, std::micro>(t1 - t0).count() / reps;
+    double us_new = std::chrono::duration<double, std::micro>(t2 - t1).count() / reps;
+    std::cout << "N=" << n << ", T=5: normalized " << us_ref << " us, fused " << us_new
+              << " us (checksum " << sink << ")" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Jump Policy Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    total_tests++;
+    if (test_against_reference() == 0) passed_tests++;
+    total_tests++;
+    if (test_edge_cases() == 0) passed_tests++;
+    total_tests++;
+    if (report_cost() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
@@ -0,0 +1,320 @@
+﻿/*
+ * test_lazy_kappa.cpp
+ * 遅延アフィン変換（静穏ステップ）の軌道が逐次更新と一致することの検証
+ * 参照には経路ごとに逐次更新する疎バックエンドを用いる
+ */
+
+#include "core/ssd_core.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <chrono>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static bool close_rel(double a, double b, double tol) {
+    return std::abs(a - b) <= tol * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+}
+
+static bool same_telemetry(const SSDTelemetry& a, const SSDTelemetry& b) {
+    const double tol = 1e-9;
+    return a.current == b.current && a.did_jump == b.did_jump && a.rewired_to == b.rewired_to &&
+           close_rel(a.E, b.E, tol) && close_rel(a.Theta, b.Theta, tol) &&
+           close_rel(a.h, b.h, tol) && close_rel(a.T, b.T, tol) && close_rel(a.H, b.H, tol) &&
+           close_rel(a.J_norm, b.J_norm, tol) && close_rel(a.align_eff, b.align_eff, tol) &&
+           close_rel(a.kappa_mean, b.kappa_mean, tol);
+}
+
+// ノイズなしでは未接触の経路が全く同じ値で推移するため、ε探索で触れた経路との
+// argmax や RelaxTop の閾値が最下位ビットの丸めで決まる場面がある。
+// 同着の幅（argmax は相対 1e-9、RelaxTop はキーの下位 bit を落とす）で両表現が一致すること
+int run_compare(const char* name, int N, const SSDParams& params, int steps,
+                double (*pressure)(int), uint64_t seed = 99) {
+    print_test_header(name);
+
+    SSDHandle* lazy = ssd_create(N, &params, seed);
+    SSDHandle* ref = ssd_create_sparse(N, &params, seed);
+    if (!lazy || !ref) {
+        std::cout << "ERROR: Failed to create handles" << std::endl;
+        ssd_destroy(lazy);
+        ssd_destroy(ref);
+        return 1;
+    }
+
+    int jumps = 0;
+    int failed_step = -1;
+    std::vector<double> row_l(N), row_r(N);
+    for (int t = 0; t < steps && failed_step < 0; ++t) {
+        SSDTelemetry tl, tr;
+        double p = pressure(t);
+        ssd_step(lazy, p, 0.1, &tl);
+        ssd_step(ref, p, 0.1, &tr);
+        jumps += tl.did_jump;
+        if (!same_telemetry(tl, tr)) failed_step = t;
+
+        // 定期的に全行を比較（変換の畳み込み前の読み出し）
+        if (t % 50 == 0) {
+            for (int r = 0; r < N && failed_step < 0; ++r) {
+                ssd_get_kappa_row(lazy, r, row_l.data(), N);
+                ssd_get_kappa_row(ref, r, row_r.data(), N);
+                for (int c = 0; c < N; ++c) {
+                    if (!close_rel(row_l[c], row_r[c], 1e-9)) {
+                        failed_step = t;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    ssd_destroy(lazy);
+    ssd_destroy(ref);
+
+    std::cout << "Seed: " << seed << ", steps: " << steps << ", jumps: " << jumps << std::endl;
+    if (failed_step >= 0) {
+        std::cout << "ERROR: lazy/eager diverged at step " << failed_step << std::endl;
+        return 1;
+    }
+    std::cout << "Lazy and eager trajectories match" << std::endl;
+    return 0;
+}
+
+// 長い無圧区間で変換の再正規化を繰り返しても kappa が一致すること
+int run_renormalize(int N, const SSDParams& params, int warmup, int quiet_steps) {
+    print_test_header("Long Quiet Decay");
+
+    SSDHandle* lazy = ssd_create(N, &params, 11);
+    SSDHandle* ref = ssd_create_sparse(N, &params, 11);
+    if (!lazy || !ref) {
+        std::cout << "ERROR: Failed to create handles" << std::endl;
+        ssd_destroy(lazy);
+        ssd_destroy(ref);
+        return 1;
+    }
+
+    for (int t = 0; t < warmup; ++t) {
+        ssd_step(lazy, 2.5, 0.1, nullptr);
+        ssd_step(ref, 2.5, 0.1, nullptr);
+    }
+
+    // 以降は跳躍・ε探索なし（kappa は決定論的な減衰のみ）
+    SSDParams quiet = params;
+    quiet.h0 = 0.0;
+    quiet.eps0 = 0.0;
+    quiet.d1 = 0.0;
+    ssd_set_params(lazy, &quiet);
+    ssd_set_params(ref, &quiet);
+    for (int t = 0; t < quiet_steps; ++t) {
+        ssd_step(lazy, 0.0, 0.1, nullptr);
+        ssd_step(ref, 0.0, 0.1, nullptr);
+    }
+
+    bool ok = true;
+    std::vector<double> row_l(N), row_r(N);
+    for (int r = 0; r < N && ok; ++r) {
+        ssd_get_kappa_row(lazy, r, row_l.data(), N);
+        ssd_get_kappa_row(ref, r, row_r.data(), N);
+        for (int c = 0; c < N; ++c) {
+            // 値自体が小さくなるので相対誤差で比較
+            double scale = std::max(std::abs(row_l[c]), std::abs(row_r[c]));
+            if (std::abs(row_l[c] - row_r[c]) > 1e-9 * scale) ok = false;
+        }
+    }
+
+    ssd_destroy(lazy);
+    ssd_destroy(ref);
+
+    std::cout << "Warmup: " << warmup << ", quiet steps: " << quiet_steps << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: kappa mismatch after quiet decay" << std::endl;
+        return 1;
+    }
+    std::cout << "Kappa matches after repeated renormalization" << std::endl;
+    return 0;
+}
+
+// 遅延ステップだけが長く続き ε探索で経路が触れられ続けても、差分更新した総和が
+// 定期的な再集計で厳密値（疎バックエンドの毎ステップ集計）から離れないこと
+int run_long_lazy(int N, int steps) {
+    print_test_header("Long Lazy Run With Exploration");
+
+    SSDParams explore{};
+    explore.h0 = 0.0;
+    explore.eps0 = 0.5;
+    explore.d2 = 0.0;
+    explore.kappa_min = 0.1;
+    explore.lam = 0.001;
+
+    SSDHandle* lazy = ssd_create(N, &explore, 7);
+    SSDHandle* ref = ssd_create_sparse(N, &explore, 7);
+    if (!lazy || !ref) {
+        std::cout << "ERROR: Failed to create handles" << std::endl;
+        ssd_destroy(lazy);
+        ssd_destroy(ref);
+        return 1;
+    }
+
+    double max_err = 0.0;
+    SSDTelemetry tl, tr;
+    for (int t = 0; t < steps; ++t) {
+        ssd_step(lazy, 0.0, 0.1, &tl);
+        ssd_step(ref, 0.0, 0.1, &tr);
+        max_err = std::max(max_err, std::abs(tl.kappa_mean - tr.kappa_mean) /
+                                        std::max(1e-12, std::abs(tr.kappa_mean)));
+    }
+
+    ssd_destroy(lazy);
+    ssd_destroy(ref);
+
+    std::cout << "Steps: " << steps << ", kappa_mean: " << tl.kappa_mean
+              << ", max rel err: " << max_err << std::endl;
+    if (max_err > 1e-9) {
+        std::cout << "ERROR: incremental kappa sum drifted" << std::endl;
+        return 1;
+    }
+    std::cout << "Incremental sums track the exact sums" << std::endl;
+    return 0;
+}
+
+// 加圧区間（通常経路）と無圧区間（遅延経路）を交互に
+static double pressure_bursts(int t) { return (t / 60) % 3 ? 0.0 : 2.5; }
+static double pressure_wave(int t) { return 1.5 + std::sin(t * 0.05); }
+
+// 非跳躍ステップの行動選択（行 argmax のキャッシュ）が、ステップ後の行を
+// 全走査した結果と一致すること（非跳躍分岐では argmax の後に kappa は変わらない）
+int run_argmax_cache(const char* name, int32_t storage, int steps) {
+    print_test_header(name);
+
+    SSDParams explore{};
+    explore.h0 = 0.3;
+    explore.eps0 = 0.6;
+    explore.d2 = 0.0;
+    explore.kappa_min = 0.1;
+    explore.lam = 0.01;
+
+    const int N = 33;
+    SSDCreateOptions opts;
+    opts.storage = storage;
+    SSDHandle* h = ssd_create_ex(N, &explore, 21, &opts);
+    if (!h) {
+        std::cout << "ERROR: Failed to create handle" << std::endl;
+        return 1;
+    }
+
+    int checked = 0, mismatches = 0;
+    int current = 0;
+    std::vector<double> row(N);
+    for (int t = 0; t < steps; ++t) {
+        SSDTelemetry tel;
+        ssd_step(h, pressure_bursts(t), 0.1, &tel);
+        if (!tel.did_jump) {
+            ssd_get_kappa_row(h, current, row.data(), N);
+            // 自己列を 1e-6 抑制した最大から相対 1e-9 以内の最初の列
+            double top = -1e300;
+            for (int k = 0; k < N; ++k) {
+                row[k] -= k == current ? 1e-6 : 0.0;
+                top = std::max(top, row[k]);
+            }
+            int best = 0;
+            while (row[best] < top - 1e-9 * std::max(1.0, std::abs(top))) ++best;
+            checked++;
+            if (best != tel.current) mismatches++;
+        }
+        current = tel.current;
+    }
+    ssd_destroy(h);
+
+    std::cout << "Steps: " << steps << ", checked: " << checked << ", mismatches: " << mismatches
+              << std::endl;
+    if (mismatches) {
+        std::cout << "ERROR: cached argmax differs from a full row scan" << std::endl;
+        return 1;
+    }
+    std::cout << "Cached argmax matches full row scans" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Lazy Kappa Transform Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    // p=0 区間の減衰（kappa_min > 0）
+    SSDParams decay{};
+    decay.kappa_min = 0.1;
+    decay.lam = 0.2;
+    decay.h0 = 0.5;
+    decay.eps0 = 0.2;
+    total_tests++;
+    if (run_compare("Pressure Bursts", 27, decay, 3000, pressure_bursts) == 0) passed_tests++;
+
+    // 同着を踏みやすい設定で複数シード（以前は約 4 分の 1 のシードで分岐していた）
+    for (uint64_t seed : {39ull, 51ull, 100ull, 101ull, 135ull, 176ull}) {
+        total_tests++;
+        if (run_compare("Pressure Bursts (Seed Sweep)", 27, decay, 3000, pressure_bursts, seed) == 0)
+            passed_tests++;
+    }
+
+    // 0.95^2000 まで縮む変換（再正規化が複数回起きる）
+    SSDParams renorm = decay;
+    renorm.kappa_min = 0.0;
+    renorm.lam = 0.5;
+    total_tests++;
+    if (run_renormalize(21, renorm, 300, 2000) == 0) passed_tests++;
+
+    // rho=0 なら加圧中もアフィン
+    SSDParams linear{};
+    linear.rho = 0.0;
+    linear.kappa_min = 0.05;
+    linear.eps0 = 0.2;
+    linear.Theta0 = 0.0;
+    linear.a1 = 0.0;
+    linear.h0 = 2.0;
+    total_tests++;
+    if (run_compare("Linear Work (rho=0)", 23, linear, 1500, pressure_wave) == 0) passed_tests++;
+
+    // G0 < 0 では下限クリップが発動し得るので通常経路に戻ること
+    SSDParams clipped = linear;
+    clipped.G0 = -0.8;
+    clipped.g = 0.1;
+    total_tests++;
+    if (run_compare("Clamp Fallback", 19, clipped, 1500, pressure_wave) == 0) passed_tests++;
+
+    total_tests++;
+    if (run_long_lazy(17, 10000) == 0) passed_tests++;
+
+    total_tests++;
+    if (run_argmax_cache("Cached Row Argmax (F64)", SSD_STORAGE_F64, 3000) == 0) passed_tests++;
+    total_tests++;
+    if (run_argmax_cache("Cached Row Argmax (BF16)", SSD_STORAGE_BF16, 3000) == 0) passed_tests++;
+
+    // 静穏ステップが行列サイズに依存しないこと（参考値の表示のみ）
+    print_test_header("Quiet Step Cost");
+    total_tests++;
+    SSDParams quiet{};
+    quiet.h0 = 0.0;
+    quiet.eps0 = 0.0;
+    SSDHandle* big = ssd_create(2048, &quiet, 5);
+    if (big) {
+        SSDTelemetry t;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < 1000; ++i) ssd_step(big, 0.0, 0.1, &t);
+        auto t1 = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / 1000.0;
+        std::cout << "N=2048, quiet steps: 1000, " << us << " us/step, kappa_mean: "
+                  << t.kappa_mean << std::endl;
+        ssd_destroy(big);
+        passed_tests++;
+    } else {
+        std::cout << "ERROR: Failed to create handle" << std::endl;
+    }
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+﻿/*
+ * test_mapped.cpp
+ * ファイルマッピング版（ssd_create_mapped）とヒープ版の一致検証
+ * （行ブロック処理は総和の丸め誤差の範囲、1ブロックならビット一致）
+ */
+
+#include "core/ssd_handle.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static const char* kPath = "ssd_test_mapped.bin";
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static bool close_to(double a, double b, double tol) {
+    return std::abs(a - b) <= tol * std::max(1.0, std::abs(b));
+}
+
+static double pressure(int t) {
+    return (t / 30) % 2 ? 0.4 : 2.5;
+}
+
+// 行ブロックの行数を設定する（0 なら作成時の既定のまま）
+static void set_block_rows(SSDHandle* h, size_t rows) {
+    if (rows == 0) return;
+    if (h->dense_f32) h->dense_f32->block_rows = rows;
+    else if (h->dense_bf16) h->dense_bf16->block_rows = rows;
+    else h->dense.block_rows = rows;
+}
+
+// tol == 0 ならビット一致を要求する
+int test_matches_heap(const char* name, const SSDParams& prm, int32_t storage, size_t block_rows,
+                      double tol) {
+    print_test_header(name);
+
+    const int N = 40;
+    SSDCreateOptions opts;
+    opts.storage = storage;
+    SSDHandle* heap = ssd_create_ex(N, &prm, 21, &opts);
+    SSDHandle* mapped = ssd_create_mapped(kPath, N, &prm, 21, &opts);
+    if (!heap || !mapped) {
+        std::cout << "ERROR: Failed to create handles" << std::endl;
+        ssd_destroy(heap);
+        ssd_destroy(mapped);
+        return 1;
+    }
+    set_block_rows(mapped, block_rows);
+
+    bool same = true;
+    int jumps = 0;
+    double max_err = 0.0;
+    for (int t = 0; t < 300 && same; ++t) {
+        SSDTelemetry a{}, b{};
+        ssd_step(heap, pressure(t), 0.1, &a);
+        ssd_step(mapped, pressure(t), 0.1, &b);
+        jumps += a.did_jump;
+        same = a.current == b.current && a.did_jump == b.did_jump && a.rewired_to == b.rewired_to;
+        const double fa[] = {a.E, a.Theta, a.h, a.T, a.H, a.J_norm, a.kappa_mean};
+        const double fb[] = {b.E, b.Theta, b.h, b.T, b.H, b.J_norm, b.kappa_mean};
+        for (int k = 0; k < 7 && same; ++k) {
+            same = tol == 0.0 ? std::memcmp(&fa[k], &fb[k], sizeof(double)) == 0
+                              : close_to(fb[k], fa[k], tol);
+            max_err = std::max(max_err, std::abs(fa[k] - fb[k]));
+        }
+    }
+
+    std::vector<double> ra(N), rb(N);
+    for (int row = 0; row < N && same; ++row) {
+        ssd_get_kappa_row(heap, row, ra.data(), N);
+        ssd_get_kappa_row(mapped, row, rb.data(), N);
+        for (int k = 0; k < N && same; ++k) {
+            same = tol == 0.0 ? std::memcmp(&ra[k], &rb[k], sizeof(double)) == 0
+                              : close_to(rb[k], ra[k], tol);
+        }
+    }
+
+    ssd_destroy(heap);
+    ssd_destroy(mapped);
+
+    // ファイルは破棄後も残る
+    FILE* f = std::fopen(kPath, "rb");
+    bool kept = f != nullptr;
+    if (f) std::fclose(f);
+    std::remove(kPath);
+
+    std::cout << "Steps: 300, jumps: " << jumps << ", max telemetry diff: " << max_err << std::endl;
+    if (!same || jumps == 0) {
+        std::cout << "ERROR: mapped handle diverged from heap handle" << std::endl;
+        return 1;
+    }
+    if (!kept) {
+        std::cout << "ERROR: backing file removed on destroy" << std::endl;
+        return 1;
+    }
+    std::cout << (tol == 0.0 ? "Bit-identical to heap handle" : "Matches heap handle") << std::endl;
+    return 0;
+}
+
+int test_file_layout() {
+    print_test_header("Backing File Layout");
+
+    const int N = 100;
+    SSDCreateOptions f32;
+    f32.storage = SSD_STORAGE_F32;
+    SSDHandle* h = ssd_create_mapped(kPath, N, nullptr, 3, &f32);
+    if (!h) {
+        std::cout << "ERROR: Failed to create mapped handle" << std::endl;
+        return 1;
+    }
+    ssd_step(h, 1.0, 0.1, nullptr);
+
+    // [kappa][w][j]、各領域はページ境界。kappa 領域の先頭行は ssd_get_kappa_row と一致
+    std::vector<double> row(N);
+    ssd_get_kappa_row(h, 0, row.data(), N);
+    ssd_destroy(h);
+
+    FILE* f = std::fopen(kPath, "rb");
+    std::vector<float> stored(N);
+    size_t got = f ? std::fread(stored.data(), sizeof(float), N, f) : 0;
+    long size = 0;
+    if (f) {
+        std::fseek(f, 0, SEEK_END);
+        size = std::ftell(f);
+        std::fclose(f);
+    }
+    std::remove(kPath);
+
+    long region = (long)((N * N * sizeof(float) + 4095) / 4096 * 4096);
+    bool ok = got == (size_t)N && size == 3 * region;
+    for (int k = 0; k < N && ok; ++k) ok = (double)stored[k] == row[k];
+
+    std::cout << "File size: " << size << " bytes" << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: unexpected backing file layout" << std::endl;
+        return 1;
+    }
+    std::cout << "kappa is stored at the head of the file" << std::endl;
+    return 0;
+}
+
+int test_rejects() {
+    print_test_header("Invalid Arguments");
+
+    SSDCreateOptions sparse;
+    sparse.sparse = 1;
+    SSDHandle* a = ssd_create_mapped(kPath, 16, nullptr, 1, &sparse);
+    SSDHandle* b = ssd_create_mapped("no_such_dir/ssd_test_mapped.bin", 16, nullptr, 1, nullptr);
+    SSDHandle* c = ssd_create_mapped(nullptr, 16, nullptr, 1, nullptr);
+    SSDHandle* d = ssd_create_mapped(kPath, 0, nullptr, 1, nullptr);
+    bool ok = !a && !b && !c && !d;
+    ssd_destroy(a);
+    ssd_destroy(b);
+    ssd_destroy(c);
+    ssd_destroy(d);
+    std::remove(kPath);
+
+    if (!ok) {
+        std::cout << "ERROR: invalid arguments accepted" << std::endl;
+        return 1;
+    }
+    std::cout << "Sparse, bad path, NULL path and N=0 rejected" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Mapped Storage Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    // 跳躍・ε探索・経路ノイズがすべて働く設定
+    SSDParams jumpy{};
+    jumpy.G0 = 0.01;
+    jumpy.g = 0.02;
+    jumpy.h0 = 5.0;
+    jumpy.eps0 = 0.3;
+    jumpy.eps_noise = 0.02;
+
+    total_tests++;
+    if (test_matches_heap("F64 Single Block", jumpy, SSD_STORAGE_F64, 0, 0.0) == 0) passed_tests++;
+    total_tests++;
+    if (test_matches_heap("F64 Row Blocks", jumpy, SSD_STORAGE_F64, 3, 1e-9) == 0) passed_tests++;
+    total_tests++;
+    if (test_matches_heap("F32 Row Blocks", jumpy, SSD_STORAGE_F32, 7, 1e-9) == 0) passed_tests++;
+    total_tests++;
+    if (test_matches_heap("BF16 Row Blocks", jumpy, SSD_STORAGE_BF16, 5, 1e-9) == 0) passed_tests++;
+    total_tests++;
+    if (test_file_layout() == 0) passed_tests++;
+    total_tests++;
+    if (test_rejects() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
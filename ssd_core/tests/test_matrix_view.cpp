@@ -0,0 +1,225 @@
+﻿/*
+ * test_matrix_view.cpp
+ * 行列ビュー（ssd_get_kappa_view / ssd_get_w_view）と部分行列コピー（ssd_copy_kappa_block）が
+ * ssd_get_kappa_row とビット一致すること、世代番号がステップごとに進むことの検証
+ */
+
+#include "core/ssd_core.h"
+#include <iostream>
+#include <vector>
+#include <cstring>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static double pressure(int t) {
+    return (t / 30) % 2 ? 0.4 : 2.5;
+}
+
+// ビューの (r, c) の真値
+static double view_value(const SSDMatrixView& v, int r, int c) {
+    size_t i = (size_t)r * v.stride + c;
+    double s;
+    if (v.elem_type == SSD_STORAGE_F32) {
+        s = ((const float*)v.data)[i];
+    } else if (v.elem_type == SSD_STORAGE_BF16) {
+        uint32_t u = (uint32_t)((const uint16_t*)v.data)[i] << 16;
+        float f;
+        std::memcpy(&f, &u, sizeof(f));
+        s = f;
+    } else {
+        s = ((const double*)v.data)[i];
+    }
+    return v.scale * s + v.offset;
+}
+
+static bool same_bits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// ビューと部分行列コピーが行の取得とビット一致すること
+int test_kappa_view(const char* name, const SSDParams& prm, const SSDCreateOptions& opts) {
+    print_test_header(name);
+
+    const int N = 37;
+    SSDHandle* h = ssd_create_ex(N, &prm, 17, &opts);
+    if (!h) {
+        std::cout << "ERROR: Failed to create handle" << std::endl;
+        return 1;
+    }
+    for (int t = 0; t < 120; ++t) ssd_step(h, pressure(t), 0.1, nullptr);
+
+    std::vector<double> rows((size_t)N * N);
+    for (int r = 0; r < N; ++r) ssd_get_kappa_row(h, r, rows.data() + (size_t)r * N, N);
+
+    SSDMatrixView v{};
+    bool ok = ssd_get_kappa_view(h, &v) == 0 && v.rows == N && v.cols == N &&
+              v.elem_type == opts.storage && v.generation == ssd_get_generation(h);
+    for (int r = 0; r < N && ok; ++r) {
+        for (int c = 0; c < N && ok; ++c) ok = same_bits(view_value(v, r, c), rows[(size_t)r * N + c]);
+    }
+
+    // 端を含む部分行列
+    const int blocks[][4] = {{0, 0, N, N}, {5, 3, 10, 7}, {N - 1, N - 4, 1, 4}, {12, 0, 9, 1}};
+    for (const auto& b : blocks) {
+        std::vector<double> out((size_t)b[2] * b[3]);
+        int64_t n = ssd_copy_kappa_block(h, b[0], b[1], b[2], b[3], out.data());
+        ok = ok && n == (int64_t)out.size();
+        for (int r = 0; r < b[2] && ok; ++r) {
+            for (int c = 0; c < b[3] && ok; ++c) {
+                ok = same_bits(out[(size_t)r * b[3] + c], rows[(size_t)(b[0] + r) * N + b[1] + c]);
+            }
+        }
+    }
+
+    std::cout << "scale: " << v.scale << ", offset: " << v.offset << std::endl;
+    ssd_destroy(h);
+    if (!ok) {
+        std::cout << "ERROR: view or block copy differs from ssd_get_kappa_row" << std::endl;
+        return 1;
+    }
+    std::cout << "View and block copies match row reads" << std::endl;
+    return 0;
+}
+
+// 疎グラフ: ビューは無いが部分行列コピーは使える
+int test_sparse_block() {
+    print_test_header("Sparse Block Copy");
+
+    const int N = 29;
+    SSDParams prm{};
+    prm.h0 = 5.0;
+    prm.eps0 = 0.3;
+    SSDHandle* h = ssd_create_sparse(N, &prm, 8);
+    for (int t = 0; t < 200; ++t) ssd_step(h, pressure(t), 0.1, nullptr);
+
+    std::vector<double> rows((size_t)N * N);
+    for (int r = 0; r < N; ++r) ssd_get_kappa_row(h, r, rows.data() + (size_t)r * N, N);
+
+    SSDMatrixView v{};
+    bool ok = ssd_get_kappa_view(h, &v) == -1 && ssd_get_w_view(h, &v) == -1;
+    for (int r0 = 0; r0 < N && ok; r0 += 4) {
+        int c0 = (r0 * 7) % N;
+        int nr = std::min(6, N - r0), nc = std::min(11, N - c0);
+        std::vector<double> out((size_t)nr * nc);
+        ok = ssd_copy_kappa_block(h, r0, c0, nr, nc, out.data()) == (int64_t)out.size();
+        for (int r = 0; r < nr && ok; ++r) {
+            for (int c = 0; c < nc && ok; ++c) {
+                ok = same_bits(out[(size_t)r * nc + c], rows[(size_t)(r0 + r) * N + c0 + c]);
+            }
+        }
+    }
+
+    ssd_destroy(h);
+    if (!ok) {
+        std::cout << "ERROR: sparse block copy differs from ssd_get_kappa_row" << std::endl;
+        return 1;
+    }
+    std::cout << "Sparse block copies match row reads, views refused" << std::endl;
+    return 0;
+}
+
+// w ビュー: 跳躍1回で再配線した経路だけが delta_w になる
+int test_w_view() {
+    print_test_header("W View");
+
+    const int N = 16;
+    SSDParams prm{};
+    prm.h0 = 1e6;  // 必ず跳躍
+    SSDHandle* h = ssd_create(N, &prm, 4);
+
+    SSDMatrixView v{};
+    bool ok = ssd_get_w_view(h, &v) == 0 && v.scale == 1.0 && v.offset == 0.0;
+    for (int i = 0; i < N * N && ok; ++i) ok = view_value(v, i / N, i % N) == 0.0;
+
+    SSDTelemetry tel{};
+    ssd_step(h, 1.0, 0.1, &tel);
+    ok = ok && tel.did_jump && ssd_get_w_view(h, &v) == 0;
+    for (int i = 0; i < N * N && ok; ++i) {
+        double expect = i == tel.rewired_to ? prm.delta_w : 0.0;  // 行0（跳躍前の位置）
+        ok = view_value(v, i / N, i % N) == expect;
+    }
+
+    ssd_destroy(h);
+    if (!ok) {
+        std::cout << "ERROR: w view does not reflect the rewired edge" << std::endl;
+        return 1;
+    }
+    std::cout << "Rewired edge visible through w view" << std::endl;
+    return 0;
+}
+
+int test_generation_and_args() {
+    print_test_header("Generation And Arguments");
+
+    const int N = 8;
+    SSDHandle* h = ssd_create(N, nullptr, 2);
+    std::vector<double> p(25, 1.0);
+    std::vector<double> out(N * N);
+
+    bool ok = ssd_get_generation(h) == 0;
+    ssd_step(h, 1.0, 0.1, nullptr);
+    ok = ok && ssd_get_generation(h) == 1;
+    ssd_step_n(h, p.data(), (int32_t)p.size(), 0.1, nullptr, 0);
+    ok = ok && ssd_get_generation(h) == 26;
+
+    ok = ok && ssd_copy_kappa_block(h, 0, 0, N + 1, 1, out.data()) == -1;
+    ok = ok && ssd_copy_kappa_block(h, 3, N - 2, 1, 3, out.data()) == -1;
+    ok = ok && ssd_copy_kappa_block(h, -1, 0, 1, 1, out.data()) == -1;
+    ok = ok && ssd_copy_kappa_block(h, 0, 0, 1, 1, nullptr) == -1;
+    ok = ok && ssd_copy_kappa_block(h, 2, 2, 0, 5, out.data()) == 0;
+    ok = ok && ssd_get_kappa_view(nullptr, nullptr) == -1 && ssd_get_generation(nullptr) == 0;
+
+    ssd_destroy(h);
+    if (!ok) {
+        std::cout << "ERROR: generation or argument checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "Generation advances per step, invalid ranges rejected" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Matrix View Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    // 経路ノイズありの通常経路
+    SSDParams noisy{};
+    noisy.h0 = 5.0;
+    noisy.eps0 = 0.3;
+    noisy.eps_noise = 0.02;
+
+    // ノイズ無し・rho=0 で遅延アフィン経路（scale/offset が 1/0 以外になる）
+    SSDParams quiet{};
+    quiet.rho = 0.0;
+
+    SSDCreateOptions f64;
+    SSDCreateOptions f32;
+    f32.storage = SSD_STORAGE_F32;
+    SSDCreateOptions bf16;
+    bf16.storage = SSD_STORAGE_BF16;
+
+    total_tests++;
+    if (test_kappa_view("Kappa View (F64)", noisy, f64) == 0) passed_tests++;
+    total_tests++;
+    if (test_kappa_view("Kappa View (F64, lazy)", quiet, f64) == 0) passed_tests++;
+    total_tests++;
+    if (test_kappa_view("Kappa View (F32)", noisy, f32) == 0) passed_tests++;
+    total_tests++;
+    if (test_kappa_view("Kappa View (BF16, lazy)", quiet, bf16) == 0) passed_tests++;
+    total_tests++;
+    if (test_sparse_block() == 0) passed_tests++;
+    total_tests++;
+    if (test_w_view() == 0) passed_tests++;
+    total_tests++;
+    if (test_generation_and_args() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
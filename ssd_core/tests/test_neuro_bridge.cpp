@@ -0,0 +1,172 @@
+﻿/*
+ * test_neuro_bridge.cpp
+ * NeuroSSDSystem のパラメータ変調の検証: 写像は基準値に対して行われ tick を重ねても
+ * ずれないこと、神経状態が動いたときだけ写像し直すこと、基準値の差し替えが反映されること、
+ * 監視用の取得関数（neurossd_get_current_node 等）がステップを進めないこと
+ */
+
+#include "api/ssd_api.h"
+#include "bridge/neuro_ssd_bridge.h"
+#include <iostream>
+#include <cmath>
+#include <cstring>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static bool same_params(const SSDParams& a, const SSDParams& b) {
+    return std::memcmp(&a, &b, sizeof(SSDParams)) == 0;
+}
+
+// 基準値に写像を1回だけ掛けた値
+static SSDParams mapped(const SSDParams& base, const NeuroState& s) {
+    SSDParams p = base;
+    MapNeuroToSSD(s, p);
+    return p;
+}
+
+// 神経状態を一定に保つと、変調後のパラメータは何 tick 後も同じ値
+int test_no_drift() {
+    print_test_header("No Compounding Drift");
+
+    NeuroSSDSystem sys(16, 3);
+    NeuroState held;
+    held.DA = 0.8f;
+    held.CORT = 0.3f;
+    sys.neuro.baseline = held;
+    sys.neuro.x = held;
+
+    SSDParams first{}, last{};
+    sys.Tick(1.0, 0.1f);
+    sys.GetSSDParams(&first);
+    for (int t = 0; t < 1000; ++t) sys.Tick(1.0, 0.1f);
+    sys.GetSSDParams(&last);
+
+    SSDParams expect = mapped(sys.GetBaseParams(), held);
+    bool ok = same_params(first, expect) && same_params(last, expect);
+    std::cout << "T0 after 1 / 1001 ticks: " << first.T0 << " / " << last.T0
+              << " (base " << sys.GetBaseParams().T0 << ")" << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: modulated params drifted from base + mapping" << std::endl;
+        return 1;
+    }
+    std::cout << "Modulation stays base + mapping" << std::endl;
+    return 0;
+}
+
+// 写像し直すのは状態が kRemapEpsilon を超えて動いたときだけ
+int test_remap_on_change() {
+    print_test_header("Remap On Change");
+
+    NeuroSSDSystem sys(16, 5);
+    SSDParams before{}, after{};
+    sys.Tick(1.0, 0.1f);
+    sys.GetSSDParams(&before);
+
+    // 基準状態のまま: 写像し直さない（値も変わらない）
+    for (int t = 0; t < 50; ++t) sys.Tick(1.0, 0.1f);
+    sys.GetSSDParams(&after);
+    bool ok = same_params(before, after);
+
+    // イベントで大きく動けば次の tick で反映される
+    sys.ApplyEvent("insult_god");
+    sys.Tick(1.0, 0.1f);
+    sys.GetSSDParams(&after);
+    ok = ok && !same_params(before, after) && same_params(after, mapped(sys.GetBaseParams(), sys.GetNeuroState()));
+
+    // 基準状態へ戻る間も、反映済みの値との差は写像の係数 × kRemapEpsilon 程度に収まる
+    double worst = 0.0;
+    for (int t = 0; t < 2000; ++t) {
+        sys.Tick(1.0, 0.1f);
+        sys.GetSSDParams(&after);
+        SSDParams exact = mapped(sys.GetBaseParams(), sys.GetNeuroState());
+        worst = std::max(worst, std::abs(after.T0 - exact.T0));
+        worst = std::max(worst, std::abs(after.Theta0 - exact.Theta0));
+        worst = std::max(worst, std::abs(after.h0 - exact.h0));
+    }
+    ok = ok && worst <= 2.0 * 0.7 * NeuroSSDSystem::kRemapEpsilon;
+
+    std::cout << "Largest lag behind exact mapping: " << worst << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: params not remapped when the neuro state moved" << std::endl;
+        return 1;
+    }
+    std::cout << "Params follow the neuro state within the remap epsilon" << std::endl;
+    return 0;
+}
+
+int test_set_base_params() {
+    print_test_header("Set Base Params");
+
+    NeuroSSDSystem sys(16, 7);
+    sys.Tick(1.0, 0.1f);
+
+    SSDParams base{};
+    base.T0 = 0.6;
+    base.eta = 0.5;
+    sys.SetBaseParams(base);
+    sys.Tick(1.0, 0.1f);
+
+    SSDParams got{};
+    sys.GetSSDParams(&got);
+    bool ok = same_params(got, mapped(base, sys.GetNeuroState()));
+    if (!ok) {
+        std::cout << "ERROR: new base params not applied" << std::endl;
+        return 1;
+    }
+    std::cout << "New base applied on the next tick" << std::endl;
+    return 0;
+}
+
+// 監視用の取得関数はステップを進めない（軌道が変わらない）
+int test_accessors_do_not_step() {
+    print_test_header("Accessors Do Not Step");
+
+    NeuroSSDSystem* polled = neurossd_create(16, 9);
+    NeuroSSDSystem* quiet = neurossd_create(16, 9);
+    bool ok = polled && quiet;
+    for (int t = 0; t < 200 && ok; ++t) {
+        SSDTelemetry a{}, b{};
+        neurossd_tick(quiet, 2.0, 0.1f, &a);
+        neurossd_tick(polled, 2.0, 0.1f, &b);
+        for (int k = 0; k < 5; ++k) {
+            ok = ok && neurossd_get_current_node(polled) == b.current && neurossd_get_heat_level(polled) == b.E;
+        }
+        ok = ok && a.current == b.current && a.E == b.E && a.kappa_mean == b.kappa_mean;
+    }
+    SSDStateView s{};
+    ok = ok && neurossd_get_ssd_state(polled, &s) == 0 && s.step == 200;
+    ok = ok && neurossd_get_current_node(nullptr) == -1 && neurossd_get_ssd_state(polled, nullptr) == -1;
+
+    neurossd_destroy(polled);
+    neurossd_destroy(quiet);
+    if (!ok) {
+        std::cout << "ERROR: accessors changed the run or returned stale values" << std::endl;
+        return 1;
+    }
+    std::cout << "Polling current node / heat leaves the run unchanged" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Neuro Bridge Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    total_tests++;
+    if (test_no_drift() == 0) passed_tests++;
+    total_tests++;
+    if (test_remap_on_change() == 0) passed_tests++;
+    total_tests++;
+    if (test_set_base_params() == 0) passed_tests++;
+    total_tests++;
+    if (test_accessors_do_not_step() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+﻿/*
+ * test_neuro_events.cpp
+ * イベント登録表（NeuroEvents）の検証: 組み込みイベントの id、id での適用と名前での適用の一致、
+ * 表の読み込み（注釈・上書き・書式誤りで何も登録しないこと）、一括適用と逐次適用の一致
+ */
+
+#include "core/neuro_population.h"
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cstdio>
+#include <cstring>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static bool same_state(const NeuroState& a, const NeuroState& b) {
+    return std::memcmp(&a, &b, sizeof(NeuroState)) == 0;
+}
+
+int test_builtin_ids() {
+    print_test_header("Builtin Events");
+
+    NeuroEventRegistry& ev = NeuroEvents();
+    int32_t praise = ev.Find("praise");
+    int32_t comfort = ev.Find("comfort");
+    bool ok = praise >= 0 && comfort >= 0 && praise != comfort && ev.Find("no_such_event") == -1 &&
+              ev.Delta(-1) == nullptr && ev.Delta((int32_t)ev.Size()) == nullptr;
+
+    // id での適用は名前での適用と同じ
+    NeuroCore by_name, by_id;
+    for (const char* name : {"praise", "insult_god", "comfort", "taboo_violation", "unknown"}) {
+        by_name.ApplyEvent(std::string_view(name));
+        by_id.ApplyEvent(ev.Find(name));
+        ok = ok && same_state(by_name.Get(), by_id.Get());
+    }
+    ok = ok && by_name.Get().DA != 0.5f;
+
+    if (!ok) {
+        std::cout << "ERROR: builtin ids or id dispatch wrong" << std::endl;
+        return 1;
+    }
+    std::cout << "praise=" << praise << ", comfort=" << comfort << ", id and name dispatch agree" << std::endl;
+    return 0;
+}
+
+int test_load_table() {
+    print_test_header("Load Table");
+
+    NeuroEventRegistry reg;
+    size_t builtin = reg.Size();
+    const char* table =
+        "# 名前 DA S5 NE AD END OXT CORT\n"
+        "ambush   -0.05 -0.05 0.20 0.25 0 -0.05 0.20   # 奇襲\n"
+        "\n"
+        "  feast 0.1 0.05 0 0 0.1 0.05 -0.05\r\n"
+        "praise 0.2 0 0 0 0 0 0\n";
+    bool ok = reg.LoadTable(table) == 3 && reg.Size() == builtin + 2;
+    int32_t ambush = reg.Find("ambush");
+    ok = ok && ambush == (int32_t)builtin && reg.Find("feast") == (int32_t)builtin + 1;
+    ok = ok && reg.Delta(ambush)->AD == 0.25f && reg.Delta(reg.Find("praise"))->DA == 0.2f;
+
+    // 書式の誤り（列数・数値）は何も登録しない
+    ok = ok && reg.LoadTable("storm 0.1 0 0 0 0 0 0\nbroken 0.1 0.2\n") == -1 && reg.Find("storm") == -1;
+    ok = ok && reg.LoadTable("storm 0.1 0 0 0 0 0 x\n") == -1 && reg.Find("storm") == -1;
+    // 有限値でない数値（strtof は nan / inf を受け付ける）も誤り
+    ok = ok && reg.LoadTable("storm nan 0 0 0 0 0 0\n") == -1 && reg.Find("storm") == -1;
+    ok = ok && reg.LoadTable("storm 0 0 0 -inf 0 0 0\n") == -1 && reg.Find("storm") == -1;
+    ok = ok && reg.LoadTable("storm 0 0 0 0 0 0 1e40\n") == -1 && reg.Find("storm") == -1;
+
+    // 名前は終端の無い部分文字列のまま引ける
+    std::string_view line = "feast_and_more";
+    ok = ok && reg.Find(line.substr(0, 5)) == (int32_t)builtin + 1 && reg.Find(line) == -1;
+
+    // ファイルから
+    const char* path = "test_neuro_events.tbl";
+    FILE* f = std::fopen(path, "wb");
+    std::fputs("storm 0 -0.1 0.15 0.1 0 0 0.1\n", f);
+    std::fclose(f);
+    ok = ok && reg.LoadFile(path) == 1 && reg.Find("storm") == (int32_t)builtin + 2;
+    ok = ok && reg.LoadFile("no_such_dir/none.tbl") == -1;
+    std::remove(path);
+
+    // 登録: 既存の名前は同じ id、空の名前は拒否
+    ok = ok && reg.Register("feast", NeuroState{}) == (int32_t)builtin + 1 && reg.Register("", NeuroState{}) == -1;
+
+    if (!ok) {
+        std::cout << "ERROR: table loading wrong" << std::endl;
+        return 1;
+    }
+    std::cout << "Table rows interned after builtins, malformed tables rejected whole" << std::endl;
+    return 0;
+}
+
+// (agent, id) の一括適用は1件ずつの適用と同じ（同じ agent への重複も順に効く）
+int test_batch_apply() {
+    print_test_header("Batch Apply");
+
+    const size_t n = 500;
+    const int pairs = 20000;
+    NeuroEventRegistry& ev = NeuroEvents();
+    std::vector<int32_t> ids = {ev.Find("praise"), ev.Find("insult_god"), ev.Find("comfort"), -1, 9999};
+
+    std::mt19937 rng(4);
+    std::vector<int32_t> agents(pairs), events(pairs);
+    for (int k = 0; k < pairs; ++k) {
+        agents[k] = (int32_t)(rng() % (n + 2)) - 1;  // 範囲外（-1, n）も含める
+        events[k] = ids[rng() % ids.size()];
+    }
+
+    NeuroPopulation batch(n), single(n);
+    batch.ApplyEvents(agents.data(), events.data(), (size_t)pairs);
+    for (int k = 0; k < pairs; ++k) {
+        if (agents[k] >= 0) single.ApplyEvent((size_t)agents[k], events[k]);
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < n && ok; ++i) ok = same_state(batch.Get(i), single.Get(i));
+    if (!ok) {
+        std::cout << "ERROR: batch apply differs from one-by-one" << std::endl;
+        return 1;
+    }
+    std::cout << pairs << " (agent, event) pairs applied in one call" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Neuro Events Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    total_tests++;
+    if (test_builtin_ids() == 0) passed_tests++;
+    total_tests++;
+    if (test_load_table() == 0) passed_tests++;
+    total_tests++;
+    if (test_batch_apply() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+﻿/*
+ * test_neuro_population.cpp
+ * NeuroPopulation（成分ごとの配列に並べた多数のエージェントの神経状態）の検証:
+ * TickAll・ApplyEvent が各エージェントを NeuroCore で更新した結果とビット一致すること、
+ * 成分配列の並び・SIMD 幅への切り上げ
+ */
+
+#include "core/neuro_population.h"
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstring>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static bool same_state(const NeuroState& a, const NeuroState& b) {
+    return std::memcmp(&a, &b, sizeof(NeuroState)) == 0;
+}
+
+static NeuroState random_state(std::mt19937& rng) {
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    NeuroState s;
+    s.DA = u(rng);
+    s.S5 = u(rng);
+    s.NE = u(rng);
+    s.AD = u(rng);
+    s.END = u(rng);
+    s.OXT = u(rng);
+    s.CORT = u(rng);
+    return s;
+}
+
+// 端数（SIMD 幅の倍数でない体数）を含めて NeuroCore と一致
+int test_matches_neuro_core() {
+    print_test_header("TickAll vs NeuroCore");
+
+    const size_t n = 1003;
+    const char* events[] = {"praise", "insult_god", "ritual_success", "taboo_violation", "comfort", "unknown"};
+    std::mt19937 rng(21);
+    NeuroPopulation pop(n);
+    std::vector<NeuroCore> cores(n);
+    for (size_t i = 0; i < n; ++i) {
+        NeuroState x = random_state(rng), b = random_state(rng);
+        cores[i].x = x;
+        cores[i].baseline = b;
+        pop.Set(i, x);
+        pop.SetBaseline(i, b);
+    }
+
+    bool ok = pop.Size() == n && pop.Stride() % NeuroPopulation::kLanes == 0 && pop.Stride() >= n;
+    for (int t = 0; t < 300 && ok; ++t) {
+        float dt = t % 7 == 0 ? 5.0f : 0.1f;
+        pop.TickAll(dt);
+        for (auto& c : cores) c.Tick(dt);
+        size_t agent = (size_t)(rng() % n);
+        const char* ev = events[t % 6];
+        pop.ApplyEvent(agent, ev);
+        cores[agent].ApplyEvent(ev);
+        for (size_t i = 0; i < n && ok; ++i) ok = same_state(pop.Get(i), cores[i].Get());
+    }
+
+    // 成分配列は NeuroState のメンバ順
+    ok = ok && pop.Channel(NEURO_CORT)[17] == cores[17].x.CORT &&
+         pop.BaselineChannel(NEURO_NE)[5] == cores[5].baseline.NE && same_state(pop.GetBaseline(9), cores[9].baseline);
+
+    if (!ok) {
+        std::cout << "ERROR: population differs from per-agent NeuroCore" << std::endl;
+        return 1;
+    }
+    std::cout << "1003 agents bit-identical to NeuroCore over 300 ticks" << std::endl;
+    return 0;
+}
+
+int test_throughput() {
+    print_test_header("TickAll Throughput");
+
+    const size_t n = 100000;
+    NeuroPopulation pop(n);
+    NeuroState high;
+    high.DA = 0.9f;
+    for (size_t i = 0; i < n; i += 3) pop.Set(i, high);
+
+    const int reps = 200;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) pop.TickAll(0.016f);
+    auto t1 = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / reps;
+
+    std::cout << "100k agents: " << us << " us per TickAll" << std::endl;
+    bool ok = pop.Get(0).DA < 0.9f && pop.Get(0).DA > 0.5f && pop.Get(1).DA == 0.5f;
+    if (!ok) {
+        std::cout << "ERROR: agents did not relax toward baseline" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Neuro Population Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    total_tests++;
+    if (test_matches_neuro_core() == 0) passed_tests++;
+    total_tests++;
+    if (test_throughput() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
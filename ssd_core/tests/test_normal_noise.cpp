@@ -0,0 +1,156 @@
+﻿/*
+ * test_normal_noise.cpp
+ * 一括正規乱数（Philox + ziggurat）の実装間一致と分布の検証
+ */
+
+#include "core/ssd_core.h"
+#include "core/ssd_random.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+// SIMD 実装がスカラーの1点計算とビット一致すること（奇数の開始位置・端数を含む）
+int test_implementations() {
+    print_test_header("SIMD vs Scalar");
+
+    const char* names[] = {"scalar", "avx2", "avx512"};
+    const size_t n = 4099;
+    const uint64_t key = 0x123456789ABCDEFULL;
+    const uint64_t step = 77;
+    int failures = 0;
+
+    for (const char* name : names) {
+        NormalFillFn fill = ssd_normal_fill_by_name(name);
+        if (!fill) {
+            std::cout << name << ": not supported on this CPU, skipped" << std::endl;
+            continue;
+        }
+        const uint64_t begins[] = {0, 1, 31, (1ULL << 33) - 3};
+        for (uint64_t begin : begins) {
+            std::vector<double> out(n);
+            fill(key, step, SSD_STREAM_EDGE_NOISE, begin, out.data(), n);
+            for (size_t i = 0; i < n; ++i) {
+                double ref = ssd_normal_at(key, step, SSD_STREAM_EDGE_NOISE, begin + i);
+                if (std::memcmp(&ref, &out[i], sizeof(double)) != 0) {
+                    failures++;
+                    break;
+                }
+            }
+        }
+        std::cout << name << ": checked" << std::endl;
+    }
+
+    if (failures) {
+        std::cout << "ERROR: " << failures << " mismatching fills" << std::endl;
+        return 1;
+    }
+    std::cout << "All implementations match ssd_normal_at" << std::endl;
+    return 0;
+}
+
+// 標準正規分布のCDF
+static double normal_cdf(double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+
+// 積率・区間頻度・裾の頻度が標準正規分布と合うこと
+int test_distribution() {
+    print_test_header("Distribution");
+
+    const size_t n = 1 << 21;
+    std::vector<double> z(n);
+    ssd_normal_fill(2024, 0, SSD_STREAM_EDGE_NOISE, 0, z.data(), n);
+
+    double m1 = 0.0, m2 = 0.0, m4 = 0.0;
+    for (double v : z) {
+        m1 += v;
+        m2 += v * v;
+        m4 += v * v * v * v;
+    }
+    m1 /= n;
+    m2 /= n;
+    m4 /= n;
+
+    // 幅 0.25 の区間頻度（[-4,4]）と、裾 |z| > 3.5（ziggurat の裾処理を通る領域）
+    const int bins = 32;
+    std::vector<double> hist(bins, 0.0);
+    size_t tail = 0;
+    for (double v : z) {
+        if (std::abs(v) > 3.5) tail++;
+        int b = (int)std::floor((v + 4.0) / 0.25);
+        if (b >= 0 && b < bins) hist[b] += 1.0;
+    }
+    double worst_sigma = 0.0;
+    for (int b = 0; b < bins; ++b) {
+        double lo = -4.0 + 0.25 * b;
+        double expect = n * (normal_cdf(lo + 0.25) - normal_cdf(lo));
+        worst_sigma = std::max(worst_sigma, std::abs(hist[b] - expect) / std::sqrt(expect));
+    }
+    double tail_expect = n * 2.0 * normal_cdf(-3.5);
+    double tail_sigma = std::abs((double)tail - tail_expect) / std::sqrt(tail_expect);
+
+    std::cout << "mean: " << m1 << ", var: " << m2 << ", kurtosis: " << m4 / (m2 * m2)
+              << ", worst bin: " << worst_sigma << " sigma, tail: " << tail << " (expect "
+              << tail_expect << ")" << std::endl;
+    if (std::abs(m1) > 0.005 || std::abs(m2 - 1.0) > 0.005 || std::abs(m4 / (m2 * m2) - 3.0) > 0.03 ||
+        worst_sigma > 5.0 || tail_sigma > 5.0) {
+        std::cout << "ERROR: samples do not follow N(0,1)" << std::endl;
+        return 1;
+    }
+    std::cout << "Moments, bins and tail match N(0,1)" << std::endl;
+    return 0;
+}
+
+// ノイズあり・なしの1ステップ時間（参考値の表示のみ）
+int report_step_cost() {
+    print_test_header("Noisy Step Cost");
+
+    const int N = 1024;
+    const int steps = 20;
+    double ms[2] = {0.0, 0.0};
+    for (int noisy = 0; noisy < 2; ++noisy) {
+        SSDParams params{};
+        params.h0 = 0.0;
+        params.eps0 = 0.0;
+        params.eps_noise = noisy ? 0.02 : 0.0;
+        SSDHandle* h = ssd_create(N, &params, 5);
+        if (!h) {
+            std::cout << "ERROR: Failed to create handle" << std::endl;
+            return 1;
+        }
+        SSDTelemetry t;
+        ssd_step(h, 1.0, 0.1, &t);
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < steps; ++i) ssd_step(h, 1.0 + (i & 1), 0.1, &t);
+        auto t1 = std::chrono::steady_clock::now();
+        ms[noisy] = std::chrono::duration<double, std::milli>(t1 - t0).count() / steps;
+        ssd_destroy(h);
+    }
+    std::cout << "N=" << N << ", noiseless: " << ms[0] << " ms/step, eps_noise=0.02: " << ms[1]
+              << " ms/step" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Normal Noise Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    total_tests++;
+    if (test_implementations() == 0) passed_tests++;
+    total_tests++;
+    if (test_distribution() == 0) passed_tests++;
+    total_tests++;
+    if (report_step_cost() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+﻿/*
+ * test_parallel_step.cpp
+ * 並列ステップ（SSDCreateOptions::threads / ssd_set_threads）の検証:
+ * 2スレッド以上ではスレッド数に依らずビット一致すること、
+ * 単一スレッドとは総和の丸め誤差の範囲で一致すること
+ */
+
+#include "core/ssd_handle.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static bool close_to(double a, double b, double tol) {
+    return std::abs(a - b) <= tol * std::max(1.0, std::abs(b));
+}
+
+static double pressure(int t) {
+    return (t / 30) % 2 ? 0.4 : 2.5;
+}
+
+// ステップ列と最終の kappa
+struct Trace {
+    std::vector<SSDTelemetry> tel;
+    std::vector<double> kappa;
+};
+
+// threads_after >= 0 なら途中で ssd_set_threads で切り替える
+static Trace run(int N, const SSDParams& prm, int32_t storage, int32_t threads, int steps,
+                 int32_t threads_after = -1) {
+    SSDCreateOptions opts;
+    opts.storage = storage;
+    opts.threads = threads;
+    SSDHandle* h = ssd_create_ex(N, &prm, 31, &opts);
+    Trace t;
+    t.tel.resize(steps);
+    for (int s = 0; s < steps; ++s) {
+        if (s == steps / 2 && threads_after >= 0) ssd_set_threads(h, threads_after);
+        ssd_step(h, pressure(s), 0.1, &t.tel[s]);
+    }
+    t.kappa.resize((size_t)N * N);
+    for (int r = 0; r < N; ++r) ssd_get_kappa_row(h, r, t.kappa.data() + (size_t)r * N, N);
+    ssd_destroy(h);
+    return t;
+}
+
+// tol == 0 ならビット一致を要求する
+static bool same_trace(const Trace& a, const Trace& b, double tol, double* max_err) {
+    for (size_t s = 0; s < a.tel.size(); ++s) {
+        const SSDTelemetry& x = a.tel[s];
+        const SSDTelemetry& y = b.tel[s];
+        if (x.current != y.current || x.did_jump != y.did_jump || x.rewired_to != y.rewired_to) {
+            return false;
+        }
+        const double fa[] = {x.E, x.Theta, x.h, x.T, x.H, x.J_norm, x.kappa_mean};
+        const double fb[] = {y.E, y.Theta, y.h, y.T, y.H, y.J_norm, y.kappa_mean};
+        for (int k = 0; k < 7; ++k) {
+            *max_err = std::max(*max_err, std::abs(fa[k] - fb[k]));
+            bool ok = tol == 0.0 ? std::memcmp(&fa[k], &fb[k], sizeof(double)) == 0
+                                 : close_to(fb[k], fa[k], tol);
+            if (!ok) return false;
+        }
+    }
+    for (size_t i = 0; i < a.kappa.size(); ++i) {
+        bool ok = tol == 0.0 ? std::memcmp(&a.kappa[i], &b.kappa[i], sizeof(double)) == 0
+                             : close_to(b.kappa[i], a.kappa[i], tol);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+int test_thread_counts(const char* name, const SSDParams& prm, int32_t storage) {
+    print_test_header(name);
+
+    // 複数ブロックになる大きさ（kappa と j の1ブロックは約 256KB）
+    const int N = 300;
+    const int steps = 150;
+    Trace single = run(N, prm, storage, 1, steps);
+    Trace two = run(N, prm, storage, 2, steps);
+
+    int jumps = 0;
+    for (const SSDTelemetry& t : single.tel) jumps += t.did_jump;
+
+    double max_err = 0.0;
+    bool ok = same_trace(single, two, 1e-9, &max_err);
+    double unused = 0.0;
+    const int32_t others[] = {3, 4, 0};
+    for (int32_t threads : others) {
+        ok = ok && same_trace(two, run(N, prm, storage, threads, steps), 0.0, &unused);
+    }
+    // 途中でスレッド数を変えても同じ
+    ok = ok && same_trace(two, run(N, prm, storage, 4, steps, 3), 0.0, &unused);
+
+    std::cout << "Steps: " << steps << ", jumps: " << jumps
+              << ", max diff vs single thread: " << max_err << std::endl;
+    if (!ok || jumps == 0) {
+        std::cout << "ERROR: parallel trajectories differ" << std::endl;
+        return 1;
+    }
+    std::cout << "threads 2/3/4/auto bit-identical, single thread within rounding" << std::endl;
+    return 0;
+}
+
+// 単一スレッドと並列を途中で行き来しても丸め誤差の範囲に収まる
+int test_switch_to_single() {
+    print_test_header("Switch To Single Thread");
+
+    const int N = 200;
+    SSDParams prm{};
+    prm.h0 = 5.0;
+    prm.eps0 = 0.3;
+    prm.eps_noise = 0.02;
+    Trace single = run(N, prm, SSD_STORAGE_F64, 1, 120);
+    Trace switched = run(N, prm, SSD_STORAGE_F64, 3, 120, 1);
+
+    double max_err = 0.0;
+    bool ok = same_trace(single, switched, 1e-9, &max_err);
+    std::cout << "max diff: " << max_err << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: switching thread count changed the trajectory" << std::endl;
+        return 1;
+    }
+    std::cout << "Trajectory preserved across ssd_set_threads" << std::endl;
+    return 0;
+}
+
+// マッピング版でも並列時はスレッド数に依らない
+int test_mapped_threads() {
+    print_test_header("Mapped With Threads");
+
+    const char* path = "ssd_test_parallel.bin";
+    const int N = 160;
+    SSDParams prm{};
+    prm.h0 = 5.0;
+    prm.eps0 = 0.3;
+    prm.eps_noise = 0.02;
+
+    std::vector<std::vector<SSDTelemetry>> traces;
+    for (int32_t threads : {2, 4}) {
+        SSDCreateOptions opts;
+        opts.storage = SSD_STORAGE_F32;
+        opts.threads = threads;
+        SSDHandle* h = ssd_create_mapped(path, N, &prm, 5, &opts);
+        if (!h) {
+            std::cout << "ERROR: Failed to create mapped handle" << std::endl;
+            return 1;
+        }
+        traces.emplace_back(100);
+        for (int s = 0; s < 100; ++s) ssd_step(h, pressure(s), 0.1, &traces.back()[s]);
+        ssd_destroy(h);
+        std::remove(path);
+    }
+    Trace a{traces[0], {}}, b{traces[1], {}};
+    double unused = 0.0;
+    if (!same_trace(a, b, 0.0, &unused)) {
+        std::cout << "ERROR: mapped trajectories depend on thread count" << std::endl;
+        return 1;
+    }
+    std::cout << "Mapped handle bit-identical for 2 and 4 threads" << std::endl;
+    return 0;
+}
+
+// 疎グラフではスレッド数を無視する
+int test_sparse_ignored() {
+    print_test_header("Sparse Ignores Threads");
+
+    SSDCreateOptions opts;
+    opts.sparse = 1;
+    opts.threads = 4;
+    SSDHandle* h = ssd_create_ex(20, nullptr, 1, &opts);
+    bool ok = h && !h->pool;
+    ssd_set_threads(h, 2);
+    ok = ok && !h->pool;
+    ssd_step(h, 1.0, 0.1, nullptr);
+    ssd_set_threads(nullptr, 2);
+    ssd_destroy(h);
+
+    if (!ok) {
+        std::cout << "ERROR: sparse handle created a thread pool" << std::endl;
+        return 1;
+    }
+    std::cout << "Sparse handle stays single threaded" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Parallel Step Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    // 跳躍・ε探索・経路ノイズがすべて働く設定
+    SSDParams noisy{};
+    noisy.G0 = 0.01;
+    noisy.g = 0.02;
+    noisy.h0 = 5.0;
+    noisy.eps0 = 0.3;
+    noisy.eps_noise = 0.02;
+
+    // ノイズ無し・rho=0 で遅延アフィン経路（畳み込み・j の展開を含む）
+    SSDParams lazy{};
+    lazy.rho = 0.0;
+    lazy.kappa_min = 0.05;
+    lazy.eps0 = 0.2;
+    lazy.Theta0 = 0.0;
+    lazy.a1 = 0.0;
+    lazy.h0 = 2.0;
+
+    total_tests++;
+    if (test_thread_counts("F64 Noisy", noisy, SSD_STORAGE_F64) == 0) passed_tests++;
+    total_tests++;
+    if (test_thread_counts("F64 Lazy", lazy, SSD_STORAGE_F64) == 0) passed_tests++;
+    total_tests++;
+    if (test_thread_counts("F32 Noisy", noisy, SSD_STORAGE_F32) == 0) passed_tests++;
+    total_tests++;
+    if (test_thread_counts("BF16 Noisy", noisy, SSD_STORAGE_BF16) == 0) passed_tests++;
+    total_tests++;
+    if (test_switch_to_single() == 0) passed_tests++;
+    total_tests++;
+    if (test_mapped_threads() == 0) passed_tests++;
+    total_tests++;
+    if (test_sparse_ignored() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+﻿/*
+ * test_philox.cpp
+ * Philox4x32-10 の既知解と、カウンタ型乱数（SSD_RNG_PHILOX）の分割非依存性の検証
+ */
+
+#include "core/ssd_core.h"
+#include "core/ssd_random.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+// Random123 の既知解（kat_vectors: philox4x32 10）
+int test_known_answers() {
+    print_test_header("Philox4x32-10 Known Answers");
+
+    struct Kat {
+        uint32_t ctr[4];
+        uint32_t key[2];
+        uint32_t expect[4];
+    };
+    const Kat kats[] = {
+        {{0, 0, 0, 0}, {0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+        {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff},
+         {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+        {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0},
+         {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+    };
+
+    int failures = 0;
+    for (const Kat& k : kats) {
+        SSDPhilox4x32 ctr{{k.ctr[0], k.ctr[1], k.ctr[2], k.ctr[3]}};
+        SSDPhilox4x32 r = ssd_philox4x32_10(ctr, k.key[0], k.key[1]);
+        if (std::memcmp(r.v, k.expect, sizeof(r.v)) != 0) failures++;
+    }
+
+    if (failures) {
+        std::cout << "ERROR: " << failures << " known-answer mismatches" << std::endl;
+        return 1;
+    }
+    std::cout << "All known-answer vectors match" << std::endl;
+    return 0;
+}
+
+// 経路ノイズを任意の区間に分けて生成しても一括生成とビット一致すること
+int test_partition_independence() {
+    print_test_header("Partition Independence");
+
+    const size_t n = 10007;
+    SSDRandom rng(SSD_RNG_PHILOX, 0xC0FFEEULL);
+    rng.step = 12345;
+
+    std::vector<double> whole(n), parts(n);
+    rng.fill_edge_noise(whole.data(), n, 0.5);
+
+    const size_t cuts[] = {0, 1, 2, 7, 64, 65, 1000, 4097, 9999, n};
+    for (size_t c = 0; c + 1 < sizeof(cuts) / sizeof(cuts[0]); ++c) {
+        rng.fill_edge_noise_range(parts.data(), cuts[c], cuts[c + 1], 0.5);
+    }
+    // 逆順（奇数幅）でも同じ
+    std::vector<double> reversed(n);
+    for (size_t end = n; end > 0;) {
+        size_t begin = end >= 33 ? end - 33 : 0;
+        rng.fill_edge_noise_range(reversed.data(), begin, end, 0.5);
+        end = begin;
+    }
+
+    // 単独の添字からも同じ値を再計算できる
+    bool random_access = true;
+    for (size_t i = 0; i < n; i += 997) {
+        double z = 0.5 * ssd_normal_at(rng.seed, rng.step, SSD_STREAM_EDGE_NOISE, i);
+        if (std::memcmp(&z, &whole[i], sizeof(double)) != 0) random_access = false;
+    }
+
+    // 分布の簡易確認（平均0・分散 0.25）
+    double mean = 0.0, sq = 0.0;
+    for (double v : whole) {
+        mean += v;
+        sq += v * v;
+    }
+    mean /= n;
+    double var = sq / n - mean * mean;
+
+    std::cout << "n: " << n << ", mean: " << mean << ", var: " << var << std::endl;
+    if (std::memcmp(whole.data(), parts.data(), n * sizeof(double)) != 0 ||
+        std::memcmp(whole.data(), reversed.data(), n * sizeof(double)) != 0 || !random_access) {
+        std::cout << "ERROR: noise depends on partitioning" << std::endl;
+        return 1;
+    }
+    if (std::abs(mean) > 0.02 || std::abs(var - 0.25) > 0.02) {
+        std::cout << "ERROR: noise moments out of range" << std::endl;
+        return 1;
+    }
+    std::cout << "Chunked, reversed and random-access noise are bit-identical" << std::endl;
+    return 0;
+}
+
+// 同じシードの Philox ハンドルは同一の軌道をたどること（跳躍・ノイズあり）
+int test_handle_reproducible(int32_t storage) {
+    print_test_header(storage == SSD_STORAGE_F64 ? "Handle Reproducibility (F64)"
+                                                 : "Handle Reproducibility (F32)");
+
+    SSDParams jumpy{};
+    jumpy.G0 = 0.01;
+    jumpy.g = 0.02;
+    jumpy.h0 = 5.0;
+    jumpy.eps0 = 0.3;
+    jumpy.eps_noise = 0.02;
+
+    SSDCreateOptions opts;
+    opts.storage = storage;
+    opts.rng = SSD_RNG_PHILOX;
+    SSDHandle* a = ssd_create_ex(24, &jumpy, 77, &opts);
+    SSDHandle* b = ssd_create_ex(24, &jumpy, 77, &opts);
+    SSDHandle* other = ssd_create_ex(24, &jumpy, 78, &opts);
+    if (!a || !b || !other) {
+        std::cout << "ERROR: Failed to create handles" << std::endl;
+        ssd_destroy(a);
+        ssd_destroy(b);
+        ssd_destroy(other);
+        return 1;
+    }
+
+    bool same = true;
+    bool differs = false;
+    int jumps = 0;
+    for (int t = 0; t < 400 && same; ++t) {
+        double p = (t / 40) % 2 ? 0.5 : 3.0;
+        SSDTelemetry ta{}, tb{}, to{};
+        ssd_step(a, p, 0.1, &ta);
+        ssd_step(b, p, 0.1, &tb);
+        ssd_step(other, p, 0.1, &to);
+        jumps += ta.did_jump;
+        same = std::memcmp(&ta, &tb, sizeof(SSDTelemetry)) == 0;
+        differs = differs || std::memcmp(&ta, &to, sizeof(SSDTelemetry)) != 0;
+    }
+
+    ssd_destroy(a);
+    ssd_destroy(b);
+    ssd_destroy(other);
+
+    std::cout << "Steps: 400, jumps: " << jumps << std::endl;
+    if (!same) {
+        std::cout << "ERROR: same seed produced different telemetry" << std::endl;
+        return 1;
+    }
+    if (!differs || jumps == 0) {
+        std::cout << "ERROR: seed has no effect or no jumps exercised" << std::endl;
+        return 1;
+    }
+    std::cout << "Same seed reproduces, different seed diverges" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Philox RNG Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    total_tests++;
+    if (test_known_answers() == 0) passed_tests++;
+    total_tests++;
+    if (test_partition_independence() == 0) passed_tests++;
+    total_tests++;
+    if (test_handle_reproducible(SSD_STORAGE_F64) == 0) passed_tests++;
+    total_tests++;
+    if (test_handle_reproducible(SSD_STORAGE_F32) == 0) passed_tests++;
+
+    print_test_header("Invalid RNG");
+    total_tests++;
+    SSDCreateOptions bad;
+    bad.rng = 5;
+    SSDHandle* h = ssd_create_ex(8, nullptr, 1, &bad);
+    if (!h) {
+        std::cout << "Unknown rng rejected" << std::endl;
+        passed_tests++;
+    } else {
+        std::cout << "ERROR: unknown rng accepted" << std::endl;
+        ssd_destroy(h);
+    }
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+﻿/*
+ * test_replay.cpp
+ * 再生ログ（ssd_record_start / ssd_replay）の検証:
+ * 任意のステップへ戻したハンドルの状態が記録元と同じ保存内容になること
+ * （途中のパラメータ・スレッド数変更、疎グラフを含む）
+ */
+
+#include "core/ssd_core.h"
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <string>
+
+static const char* kLog = "ssd_test_replay.log";
+static const char* kRef = "ssd_test_replay_ref.bin";
+static const char* kGot = "ssd_test_replay_got.bin";
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static double pressure(int t) {
+    return (t / 30) % 2 ? 0.4 : 2.5;
+}
+
+static std::vector<unsigned char> read_file(const char* path) {
+    std::vector<unsigned char> out;
+    FILE* f = std::fopen(path, "rb");
+    if (!f) return out;
+    unsigned char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    std::fclose(f);
+    return out;
+}
+
+// 保存内容（方策・乱数状態・kappa / w など）がバイト単位で一致するか
+static bool same_state(SSDHandle* a, SSDHandle* b) {
+    if (ssd_save_state(a, kRef) != SSD_STATE_OK || ssd_save_state(b, kGot) != SSD_STATE_OK) return false;
+    std::vector<unsigned char> x = read_file(kRef), y = read_file(kGot);
+    return !x.empty() && x == y;
+}
+
+// 記録しながら進め、targets の各ステップで記録元の状態を控えておき、再生と比べる
+int test_replay(const char* name, const SSDCreateOptions& opts, bool change_threads) {
+    print_test_header(name);
+
+    const int N = 48;
+    SSDParams prm{};
+    prm.G0 = 0.01;
+    prm.g = 0.02;
+    prm.h0 = 5.0;
+    prm.eps0 = 0.3;
+    prm.eps_noise = opts.sparse ? 0.0 : 0.02;  // 疎グラフは経路ノイズを受け付けない
+    SSDHandle* h = ssd_create_ex(N, &prm, 19, &opts);
+
+    // 記録前に進めておく（ステップ番号は作成時から数える）
+    for (int t = 0; t < 50; ++t) ssd_step(h, pressure(t), 0.1, nullptr);
+    bool ok = ssd_record_start(h, kLog, 400) == SSD_STATE_OK;
+    ok = ok && ssd_record_start(h, kLog, 400) == SSD_STATE_ERR_ARG;  // 記録中
+
+    const uint64_t targets[] = {50, 51, 449, 450, 451, 700, 1001, 1249, 1550};
+    std::vector<std::string> snapshots;
+    std::vector<int32_t> snapshot_threads;  // 読み込みでは復元されないので控えておく
+    int32_t threads = opts.threads;
+    int jumps = 0;
+    size_t next = 0;
+    for (uint64_t step = 50; ok; step = ssd_get_step(h)) {
+        if (step == 700) {
+            prm.h0 = 2.0;  // ステップ 700 の直後に変更（700 の再生に含まれる）
+            ssd_set_params(h, &prm);
+        }
+        if (step == 1001 && change_threads) ssd_set_threads(h, threads = 3);
+        if (next < sizeof(targets) / sizeof(targets[0]) && step == targets[next]) {
+            std::string path = "ssd_test_replay_" + std::to_string(step) + ".bin";
+            ok = ssd_save_state(h, path.c_str()) == SSD_STATE_OK;
+            snapshots.push_back(path);
+            snapshot_threads.push_back(threads);
+            ++next;
+        }
+        if (step == 1550) break;
+
+        int t = (int)step;
+        SSDTelemetry tel{};
+        if (t % 7 == 0) {
+            // ssd_step_n も1ステップずつ記録される（dt も変える）
+            double p = pressure(t);
+            ssd_step_n(h, &p, 1, 0.05, &tel, 1);
+        } else {
+            ssd_step(h, pressure(t), 0.1, &tel);
+        }
+        jumps += tel.did_jump;
+    }
+    ok = ok && ssd_record_stop(h) == SSD_STATE_OK && ssd_record_stop(h) == SSD_STATE_ERR_ARG;
+    ok = ok && next == sizeof(targets) / sizeof(targets[0]);
+
+    for (size_t k = 0; k < snapshots.size() && ok; ++k) {
+        int32_t err = 0;
+        SSDHandle* ref = ssd_load_state(snapshots[k].c_str(), &err);
+        if (ref) ssd_set_threads(ref, snapshot_threads[k]);
+        SSDHandle* got = ssd_replay(kLog, targets[k], &err);
+        ok = ref && got && ssd_get_step(got) == targets[k] && same_state(ref, got);
+        if (!ok) std::cout << "Mismatch at step " << targets[k] << " (err " << err << ")" << std::endl;
+        ssd_destroy(ref);
+        ssd_destroy(got);
+    }
+
+    // 記録の範囲外
+    int32_t err = 0;
+    ok = ok && !ssd_replay(kLog, 49, &err) && err == SSD_STATE_ERR_ARG;
+    ok = ok && !ssd_replay(kLog, 1551, &err) && err == SSD_STATE_ERR_ARG;
+
+    ssd_destroy(h);
+    for (const std::string& s : snapshots) std::remove(s.c_str());
+    std::remove(kLog);
+    std::remove(kRef);
+    std::remove(kGot);
+
+    std::cout << "Replayed " << snapshots.size() << " positions, jumps while recording: " << jumps
+              << std::endl;
+    if (!ok || jumps == 0) {
+        std::cout << "ERROR: replayed state differs from the recorded run" << std::endl;
+        return 1;
+    }
+    std::cout << "Every replayed position matches the recorded state" << std::endl;
+    return 0;
+}
+
+// 書きかけで止まったログも、最後の完全なレコードまでは再生できる
+int test_truncated() {
+    print_test_header("Truncated Log");
+
+    SSDHandle* h = ssd_create(24, nullptr, 5);
+    bool ok = ssd_record_start(h, kLog, 100) == SSD_STATE_OK;
+    for (int t = 0; t < 250; ++t) ssd_step(h, pressure(t), 0.1, nullptr);
+    ok = ok && ssd_record_stop(h) == SSD_STATE_OK;
+
+    // 末尾の入力レコード（ステップ 200..249）を途中で切る
+    std::vector<unsigned char> log = read_file(kLog);
+    FILE* f = std::fopen(kLog, "wb");
+    ok = ok && f && std::fwrite(log.data(), 1, log.size() - 100, f) == log.size() - 100;
+    if (f) std::fclose(f);
+
+    int32_t err = 0;
+    SSDHandle* a = ssd_replay(kLog, 200, &err);
+    ok = ok && a && ssd_get_step(a) == 200;
+    ok = ok && !ssd_replay(kLog, 240, &err) && err == SSD_STATE_ERR_ARG;
+
+    // 形式違い
+    std::FILE* g = std::fopen(kRef, "wb");
+    if (g) {
+        std::fputs("not a replay log, just some text", g);
+        std::fclose(g);
+    }
+    ok = ok && !ssd_replay(kRef, 0, &err) && err == SSD_STATE_ERR_FORMAT;
+    ok = ok && !ssd_replay("no_such_file.log", 0, &err) && err == SSD_STATE_ERR_IO;
+
+    ssd_destroy(a);
+    ssd_destroy(h);
+    std::remove(kLog);
+    std::remove(kRef);
+    if (!ok) {
+        std::cout << "ERROR: truncated or invalid log handled incorrectly" << std::endl;
+        return 1;
+    }
+    std::cout << "Truncated tail ignored, invalid files rejected" << std::endl;
+    return 0;
+}
+
+int test_rejects() {
+    print_test_header("Invalid Arguments");
+
+    const char* mapped_path = "ssd_test_replay_mapped.bin";
+    SSDHandle* m = ssd_create_mapped(mapped_path, 16, nullptr, 1, nullptr);
+    bool ok = m && ssd_record_start(m, kLog, 10) == SSD_STATE_ERR_ARG;
+    ok = ok && ssd_record_start(nullptr, kLog, 10) == SSD_STATE_ERR_ARG;
+    ok = ok && ssd_record_start(m, nullptr, 10) == SSD_STATE_ERR_ARG;
+    ok = ok && ssd_record_stop(m) == SSD_STATE_ERR_ARG;
+    ssd_destroy(m);
+    std::remove(mapped_path);
+
+    // 記録したまま破棄してもログは閉じられ、再生できる
+    SSDHandle* h = ssd_create(16, nullptr, 2);
+    ok = ok && ssd_record_start(h, kLog, 0) == SSD_STATE_OK;
+    for (int t = 0; t < 30; ++t) ssd_step(h, pressure(t), 0.1, nullptr);
+    ssd_destroy(h);
+    int32_t err = 0;
+    SSDHandle* r = ssd_replay(kLog, 30, &err);
+    ok = ok && r && ssd_get_step(r) == 30;
+    ssd_destroy(r);
+    std::remove(kLog);
+
+    if (!ok) {
+        std::cout << "ERROR: invalid recording requests accepted" << std::endl;
+        return 1;
+    }
+    std::cout << "Mapped handles, NULL arguments and double stop rejected" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Replay Log Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    SSDCreateOptions f64;
+    SSDCreateOptions bf16;
+    bf16.storage = SSD_STORAGE_BF16;
+    bf16.rng = SSD_RNG_PHILOX;
+    SSDCreateOptions sparse;
+    sparse.sparse = 1;
+
+    total_tests++;
+    if (test_replay("Dense F64", f64, true) == 0) passed_tests++;
+    total_tests++;
+    if (test_replay("Dense BF16 Philox", bf16, false) == 0) passed_tests++;
+    total_tests++;
+    if (test_replay("Sparse", sparse, false) == 0) passed_tests++;
+    total_tests++;
+    if (test_truncated() == 0) passed_tests++;
+    total_tests++;
+    if (test_rejects() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
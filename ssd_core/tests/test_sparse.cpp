@@ -0,0 +1,170 @@
+﻿/*
+ * test_sparse.cpp
+ * ssd_create_sparse と ssd_create のテレメトリ・kappa一致検証、経路ノイズの拒否
+ */
+
+#include "core/ssd_core.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static bool close_rel(double a, double b, double tol) {
+    return std::abs(a - b) <= tol * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+}
+
+static bool same_telemetry(const SSDTelemetry& a, const SSDTelemetry& b) {
+    const double tol = 1e-9;
+    return a.current == b.current && a.did_jump == b.did_jump && a.rewired_to == b.rewired_to &&
+           close_rel(a.E, b.E, tol) && close_rel(a.Theta, b.Theta, tol) &&
+           close_rel(a.h, b.h, tol) && close_rel(a.T, b.T, tol) && close_rel(a.H, b.H, tol) &&
+           close_rel(a.J_norm, b.J_norm, tol) && close_rel(a.align_eff, b.align_eff, tol) &&
+           close_rel(a.kappa_mean, b.kappa_mean, tol);
+}
+
+int run_compare(const char* name, int N, const SSDParams& params, int steps,
+                double (*pressure)(int)) {
+    print_test_header(name);
+
+    SSDHandle* dense = ssd_create(N, &params, 2024);
+    SSDHandle* sparse = ssd_create_sparse(N, &params, 2024);
+    if (!dense || !sparse) {
+        std::cout << "ERROR: Failed to create handles" << std::endl;
+        ssd_destroy(dense);
+        ssd_destroy(sparse);
+        return 1;
+    }
+
+    int jumps = 0;
+    int failed_step = -1;
+    std::vector<double> row_d(N), row_s(N);
+    for (int t = 0; t < steps && failed_step < 0; ++t) {
+        SSDTelemetry td, ts;
+        double p = pressure(t);
+        ssd_step(dense, p, 0.1, &td);
+        ssd_step(sparse, p, 0.1, &ts);
+        jumps += td.did_jump;
+        if (!same_telemetry(td, ts)) failed_step = t;
+
+        // 定期的に全行を比較
+        if (t % 25 == 0) {
+            for (int r = 0; r < N && failed_step < 0; ++r) {
+                ssd_get_kappa_row(dense, r, row_d.data(), N);
+                ssd_get_kappa_row(sparse, r, row_s.data(), N);
+                for (int c = 0; c < N; ++c) {
+                    if (!close_rel(row_d[c], row_s[c], 1e-9)) {
+                        failed_step = t;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    ssd_destroy(dense);
+    ssd_destroy(sparse);
+
+    std::cout << "Steps: " << steps << ", jumps: " << jumps << std::endl;
+    if (failed_step >= 0) {
+        std::cout << "ERROR: dense/sparse diverged at step " << failed_step << std::endl;
+        return 1;
+    }
+    std::cout << "Dense and sparse trajectories match" << std::endl;
+    return 0;
+}
+
+static double pressure_wave(int t) { return 1.5 + std::sin(t * 0.05); }
+// 経路ノイズは疎表現では再現できないので、作成・パラメータ変更とも拒否すること
+int test_noise_rejected() {
+    print_test_header("Noise Rejected");
+
+    SSDParams noisy{};
+    noisy.eps_noise = 0.02;
+    SSDCreateOptions opts;
+    opts.sparse = 1;
+    bool ok = !ssd_create_sparse(16, &noisy, 3) && !ssd_create_ex(16, &noisy, 3, &opts);
+
+    SSDHandle* h = ssd_create_sparse(16, nullptr, 3);
+    SSDParams before{}, after{};
+    ssd_get_params(h, &before);
+    ok = ok && h && ssd_set_params(h, &noisy) == 0;
+    ssd_get_params(h, &after);
+    ok = ok && after.eps_noise == 0.0 && after.h0 == before.h0;
+
+    // ノイズ無しの変更は通る
+    SSDParams quiet = noisy;
+    quiet.eps_noise = 0.0;
+    quiet.h0 = 4.0;
+    ok = ok && ssd_set_params(h, &quiet) == 1;
+    ssd_get_params(h, &after);
+    ok = ok && after.h0 == 4.0;
+    ssd_destroy(h);
+
+    // 密グラフはそのまま受け付ける
+    SSDHandle* dense = ssd_create(16, &noisy, 3);
+    ok = ok && dense && ssd_set_params(dense, &noisy) == 1;
+    ssd_destroy(dense);
+
+    if (!ok) {
+        std::cout << "ERROR: sparse handle accepted eps_noise > 0" << std::endl;
+        return 1;
+    }
+    std::cout << "eps_noise > 0 rejected by ssd_create_sparse, ssd_create_ex and ssd_set_params"
+              << std::endl;
+    return 0;
+}
+
+static double pressure_bursts(int t) { return (t / 40) % 2 ? 0.0 : 3.0; }
+
+int main() {
+    std::cout << "SSD Core - Sparse Backend Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    SSDParams base{};
+    total_tests++;
+    if (run_compare("Default Params", 24, base, 400, pressure_wave) == 0) passed_tests++;
+
+    // 跳躍・RelaxTop・ε探索が頻発する設定
+    SSDParams jumpy{};
+    jumpy.G0 = 0.01;
+    jumpy.g = 0.02;
+    jumpy.h0 = 5.0;
+    jumpy.eps0 = 0.3;
+    jumpy.q_relax = 0.17;
+    jumpy.eps_relax = 0.05;
+    total_tests++;
+    if (run_compare("Jump-Heavy", 31, jumpy, 600, pressure_bursts) == 0) passed_tests++;
+
+    total_tests++;
+    if (test_noise_rejected() == 0) passed_tests++;
+
+    // 大規模疎グラフが作成・ステップできること
+    print_test_header("Large Sparse Graph");
+    total_tests++;
+    SSDHandle* big = ssd_create_sparse(100000, &jumpy, 7);
+    if (big) {
+        SSDTelemetry t;
+        int jumps = 0;
+        for (int i = 0; i < 200; ++i) {
+            ssd_step(big, pressure_bursts(i), 0.1, &t);
+            jumps += t.did_jump;
+        }
+        std::cout << "N=100000, steps: 200, jumps: " << jumps
+                  << ", kappa_mean: " << t.kappa_mean << std::endl;
+        ssd_destroy(big);
+        passed_tests++;
+    } else {
+        std::cout << "ERROR: Failed to create sparse handle" << std::endl;
+    }
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
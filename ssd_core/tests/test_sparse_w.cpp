@@ -0,0 +1,216 @@
+﻿/*
+ * test_sparse_w.cpp
+ * w の疎な保持（触れた経路だけ、ビュー要求時に密な配列を作る）の検証:
+ * 最初から密な配列を持つハンドルと値がビット一致すること、
+ * 状態保存・復元で疎なまま引き継がれること、表が大きくなれば密な配列に切り替わること
+ */
+
+#include "core/ssd_handle.h"
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+static const char* kPath = "ssd_test_sparse_w.bin";
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static double pressure(int t) {
+    return (t / 30) % 2 ? 0.4 : 2.5;
+}
+
+static SSDParams jumpy_params() {
+    SSDParams prm{};
+    prm.G0 = 0.01;
+    prm.g = 0.02;
+    prm.h0 = 5.0;
+    prm.eps0 = 0.3;
+    prm.eps_noise = 0.02;
+    return prm;
+}
+
+// w の格納値の列（密な配列の有無を問わない）
+template <class G>
+static std::vector<double> w_values(const G& g) {
+    std::vector<double> out((size_t)g.N * g.N);
+    for (size_t i = 0; i < out.size(); ++i) out[i] = (double)G::Traits::load(g.w_at(i));
+    return out;
+}
+
+static std::vector<double> w_values(SSDHandle* h) {
+    if (h->dense_f32) return w_values(*h->dense_f32);
+    if (h->dense_bf16) return w_values(*h->dense_bf16);
+    return w_values(h->dense);
+}
+
+static size_t dense_w_size(SSDHandle* h) {
+    if (h->dense_f32) return h->dense_f32->w.size();
+    if (h->dense_bf16) return h->dense_bf16->w.size();
+    return h->dense.w.size();
+}
+
+static bool same_bits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static bool same_telemetry(const SSDTelemetry& a, const SSDTelemetry& b) {
+    return same_bits(a.E, b.E) && same_bits(a.Theta, b.Theta) && same_bits(a.h, b.h) &&
+           same_bits(a.T, b.T) && same_bits(a.H, b.H) && same_bits(a.J_norm, b.J_norm) &&
+           same_bits(a.align_eff, b.align_eff) && same_bits(a.kappa_mean, b.kappa_mean) &&
+           a.current == b.current && a.did_jump == b.did_jump && a.rewired_to == b.rewired_to;
+}
+
+static bool same_values(const std::vector<double>& a, const std::vector<double>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+}
+
+// ビューを作成直後に取ったハンドル（最初から密）と、最後に取ったハンドルの比較
+int test_matches_dense(const char* name, int32_t storage) {
+    print_test_header(name);
+
+    const int N = 200;  // BF16 でも表の方が小さい大きさ
+    SSDParams prm = jumpy_params();
+    SSDCreateOptions opts;
+    opts.storage = storage;
+    SSDHandle* dense = ssd_create_ex(N, &prm, 13, &opts);
+    SSDHandle* lazy = ssd_create_ex(N, &prm, 13, &opts);
+    SSDMatrixView v{};
+    bool ok = dense && lazy && ssd_get_w_view(dense, &v) == 0 && dense_w_size(lazy) == 0;
+
+    int jumps = 0;
+    for (int t = 0; t < 400 && ok; ++t) {
+        SSDTelemetry a{}, b{};
+        ssd_step(dense, pressure(t), 0.1, &a);
+        ssd_step(lazy, pressure(t), 0.1, &b);
+        jumps += a.did_jump;
+        ok = same_telemetry(a, b);
+    }
+
+    // 密な配列を作る前後で同じ値が読める
+    std::vector<double> expect = ok ? w_values(dense) : std::vector<double>();
+    ok = ok && dense_w_size(lazy) == 0 && same_values(w_values(lazy), expect);
+    ok = ok && ssd_get_w_view(lazy, &v) == 0 && dense_w_size(lazy) == (size_t)N * N;
+    ok = ok && same_values(w_values(lazy), expect);
+
+    // 以後の更新は密な配列に書かれる
+    for (int t = 400; t < 500 && ok; ++t) {
+        ssd_step(dense, pressure(t), 0.1, nullptr);
+        ssd_step(lazy, pressure(t), 0.1, nullptr);
+    }
+    ok = ok && same_values(w_values(lazy), w_values(dense));
+
+    ssd_destroy(dense);
+    ssd_destroy(lazy);
+    std::cout << "Steps: 500, jumps: " << jumps << std::endl;
+    if (!ok || jumps == 0) {
+        std::cout << "ERROR: sparse w differs from dense w" << std::endl;
+        return 1;
+    }
+    std::cout << "Sparse w matches dense w before and after materialization" << std::endl;
+    return 0;
+}
+
+int test_state_round_trip() {
+    print_test_header("State Round Trip");
+
+    const int N = 100;
+    SSDParams prm = jumpy_params();
+    SSDCreateOptions opts;
+    opts.storage = SSD_STORAGE_F32;
+    SSDHandle* h = ssd_create_ex(N, &prm, 3, &opts);
+    for (int t = 0; t < 300; ++t) ssd_step(h, pressure(t), 0.1, nullptr);
+    size_t touched = h->dense_f32->w_edges.size();
+
+    int32_t err = 0;
+    bool ok = touched > 0 && ssd_save_state(h, kPath) == SSD_STATE_OK;
+    SSDHandle* loaded = ok ? ssd_load_state(kPath, &err) : nullptr;
+    ok = ok && loaded && dense_w_size(loaded) == 0 &&
+         loaded->dense_f32->w_edges.size() == touched && same_values(w_values(loaded), w_values(h));
+
+    // 密な配列を作ってから保存したものも読める
+    SSDMatrixView v{};
+    ok = ok && ssd_get_w_view(h, &v) == 0 && ssd_save_state(h, kPath) == SSD_STATE_OK;
+    SSDHandle* dense = ok ? ssd_load_state(kPath, &err) : nullptr;
+    ok = ok && dense && dense_w_size(dense) == (size_t)N * N && same_values(w_values(dense), w_values(h));
+
+    // 以後のステップも一致
+    for (int t = 300; t < 400 && ok; ++t) {
+        SSDTelemetry a{}, b{};
+        ssd_step(h, pressure(t), 0.1, &a);
+        ssd_step(loaded, pressure(t), 0.1, &b);
+        ok = same_telemetry(a, b);
+    }
+    ok = ok && same_values(w_values(loaded), w_values(h));
+
+    ssd_destroy(h);
+    ssd_destroy(loaded);
+    ssd_destroy(dense);
+    std::remove(kPath);
+    std::cout << "Touched edges: " << touched << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: sparse w not preserved by save/load (err " << err << ")" << std::endl;
+        return 1;
+    }
+    std::cout << "Sparse w saved as edge list and restored" << std::endl;
+    return 0;
+}
+
+// 表が密な配列より大きくなる前に密な配列へ切り替わる
+int test_switch_to_dense() {
+    print_test_header("Switch To Dense");
+
+    // 先に確保する表（8N 経路分）は密な配列より小さいが、2倍に広げると上回る大きさ
+    const int N = 48;
+    SSDParams prm = jumpy_params();
+    prm.eps0 = 1.0;
+    SSDHandle* h = ssd_create(N, &prm, 77);
+    SSDHandle* ref = ssd_create(N, &prm, 77);
+    SSDMatrixView v{};
+    bool ok = dense_w_size(h) == 0 && ssd_get_w_view(ref, &v) == 0;
+
+    size_t max_touched = 0;
+    for (int t = 0; t < 20000 && ok; ++t) {
+        ssd_step(h, pressure(t), 0.1, nullptr);
+        ssd_step(ref, pressure(t), 0.1, nullptr);
+        max_touched = std::max(max_touched, h->dense.w_edges.size());
+    }
+    ok = ok && dense_w_size(h) == (size_t)N * N && h->dense.w_edges.size() == 0 &&
+         SSDEdgeMap<double>::bytes_for(max_touched) < (size_t)N * N * sizeof(double) &&
+         same_values(w_values(h), w_values(ref));
+
+    ssd_destroy(h);
+    ssd_destroy(ref);
+    std::cout << "Edges held before switching: " << max_touched << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: w did not switch to a dense array" << std::endl;
+        return 1;
+    }
+    std::cout << "Switched to dense w with identical values" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Sparse W Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    total_tests++;
+    if (test_matches_dense("F64", SSD_STORAGE_F64) == 0) passed_tests++;
+    total_tests++;
+    if (test_matches_dense("F32", SSD_STORAGE_F32) == 0) passed_tests++;
+    total_tests++;
+    if (test_matches_dense("BF16", SSD_STORAGE_BF16) == 0) passed_tests++;
+    total_tests++;
+    if (test_state_round_trip() == 0) passed_tests++;
+    total_tests++;
+    if (test_switch_to_dense() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
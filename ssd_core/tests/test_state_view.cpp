@@ -0,0 +1,127 @@
+﻿/*
+ * test_state_view.cpp
+ * ssd_get_state の検証: 値が直前ステップのテレメトリと一致すること、読んでも軌道
+ * （乱数・行列）が変わらないこと、保存・復元で引き継がれること
+ */
+
+#include "core/ssd_core.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static bool same_bits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static bool same_telemetry(const SSDTelemetry& a, const SSDTelemetry& b) {
+    return same_bits(a.E, b.E) && same_bits(a.Theta, b.Theta) && same_bits(a.h, b.h) &&
+           same_bits(a.T, b.T) && same_bits(a.H, b.H) && same_bits(a.J_norm, b.J_norm) &&
+           same_bits(a.align_eff, b.align_eff) && same_bits(a.kappa_mean, b.kappa_mean) &&
+           a.current == b.current && a.did_jump == b.did_jump && a.rewired_to == b.rewired_to;
+}
+
+static double pressure(int t) {
+    return (t / 30) % 2 ? 0.4 : 2.5;
+}
+
+static SSDParams jumpy_params() {
+    SSDParams prm{};
+    prm.h0 = 5.0;
+    prm.eps0 = 0.3;
+    return prm;
+}
+
+static bool matches(const SSDStateView& s, const SSDTelemetry& t, uint64_t step) {
+    return s.current == t.current && same_bits(s.E, t.E) && same_bits(s.T, t.T) &&
+           same_bits(s.kappa_mean, t.kappa_mean) && s.step == step;
+}
+
+static bool same_view(const SSDStateView& a, const SSDStateView& b) {
+    return same_bits(a.E, b.E) && same_bits(a.T, b.T) && same_bits(a.F, b.F) &&
+           same_bits(a.kappa_mean, b.kappa_mean) && a.step == b.step && a.current == b.current;
+}
+
+// 毎ステップ読んでも読まない場合と同じ軌道になり、値はテレメトリと一致
+int test_matches_telemetry(const char* name, bool sparse) {
+    print_test_header(name);
+
+    const int N = 24;
+    SSDParams prm = jumpy_params();
+    SSDHandle* quiet = sparse ? ssd_create_sparse(N, &prm, 31) : ssd_create(N, &prm, 31);
+    SSDHandle* polled = sparse ? ssd_create_sparse(N, &prm, 31) : ssd_create(N, &prm, 31);
+
+    SSDStateView s{};
+    bool ok = ssd_get_state(polled, &s) == 0 && s.step == 0 && s.current == 0 && s.kappa_mean == 0.0;
+    int jumps = 0;
+    for (int t = 0; t < 300 && ok; ++t) {
+        SSDTelemetry a{}, b{};
+        ssd_step(quiet, pressure(t), 0.1, &a);
+        for (int k = 0; k < 3; ++k) ssd_get_state(polled, &s);
+        ssd_step(polled, pressure(t), 0.1, &b);
+        ok = same_telemetry(a, b);
+        ok = ok && ssd_get_state(polled, &s) == 0 && matches(s, b, (uint64_t)t + 1);
+        jumps += b.did_jump;
+    }
+
+    ssd_destroy(quiet);
+    ssd_destroy(polled);
+    std::cout << "Jumps: " << jumps << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: state view differs from telemetry or perturbed the run" << std::endl;
+        return 1;
+    }
+    std::cout << "State view matches telemetry, polling leaves the run unchanged" << std::endl;
+    return 0;
+}
+
+int test_save_load() {
+    print_test_header("Save And Load");
+
+    const int N = 20;
+    SSDParams prm = jumpy_params();
+    SSDHandle* h = ssd_create(N, &prm, 5);
+    for (int t = 0; t < 80; ++t) ssd_step(h, pressure(t), 0.1, nullptr);
+
+    const char* path = "test_state_view.ssd";
+    int32_t err = 0;
+    SSDHandle* r = ssd_save_state(h, path) == SSD_STATE_OK ? ssd_load_state(path, &err) : nullptr;
+    std::remove(path);
+
+    SSDStateView a{}, b{};
+    bool ok = r && ssd_get_state(h, &a) == 0 && ssd_get_state(r, &b) == 0 &&
+              same_view(a, b) && a.kappa_mean > 0.0;
+    ok = ok && ssd_get_state(nullptr, &a) == -1 && ssd_get_state(h, nullptr) == -1;
+
+    ssd_destroy(h);
+    ssd_destroy(r);
+    if (!ok) {
+        std::cout << "ERROR: state view not preserved across save/load" << std::endl;
+        return 1;
+    }
+    std::cout << "kappa_mean " << a.kappa_mean << " preserved across save/load" << std::endl;
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - State View Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    total_tests++;
+    if (test_matches_telemetry("Dense", false) == 0) passed_tests++;
+    total_tests++;
+    if (test_matches_telemetry("Sparse", true) == 0) passed_tests++;
+    total_tests++;
+    if (test_save_load() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
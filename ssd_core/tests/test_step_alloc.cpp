@@ -0,0 +1,127 @@
+﻿/*
+ * test_step_alloc.cpp
+ * ssd_step / ssd_ensemble_step 定常状態ヒープ確保ゼロの検証
+ */
+
+#include "core/ssd_core.h"
+#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// グローバルoperator newを差し替えて確保回数を数える
+static std::atomic<long> g_alloc_count{0};
+
+void* operator new(std::size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+int run_alloc_test(const char* name, const SSDParams& params, double p) {
+    print_test_header(name);
+
+    SSDHandle* h = ssd_create(64, &params, 42);
+    if (!h) {
+        std::cout << "ERROR: Failed to create handle" << std::endl;
+        return 1;
+    }
+
+    SSDTelemetry telem;
+    // ウォームアップ
+    for (int i = 0; i < 10; ++i) ssd_step(h, p, 0.1, &telem);
+
+    int jumps = 0;
+    long before = g_alloc_count.load();
+    for (int i = 0; i < 500; ++i) {
+        ssd_step(h, p, 0.1, &telem);
+        jumps += telem.did_jump;
+    }
+    long allocs = g_alloc_count.load() - before;
+
+    ssd_destroy(h);
+
+    std::cout << "Steps: 500, jumps: " << jumps << ", allocations: " << allocs << std::endl;
+    if (allocs != 0) {
+        std::cout << "ERROR: ssd_step allocated during steady-state stepping" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// アンサンブルも並列ステップ（作業者への区間配布を含む）で確保しないこと。
+// M は8の倍数でない（メンバー枠の余りを含む）
+int run_ensemble_alloc_test(const char* name, const SSDParams& params, double p) {
+    print_test_header(name);
+
+    const int M = 70;
+    SSDEnsemble* e = ssd_ensemble_create(M, 16, &params, 42);
+    if (!e) {
+        std::cout << "ERROR: Failed to create ensemble" << std::endl;
+        return 1;
+    }
+    ssd_ensemble_set_threads(e, 2);
+
+    std::vector<double> pv(M, p);
+    std::vector<SSDTelemetry> telem(M);
+    for (int i = 0; i < 10; ++i) ssd_ensemble_step(e, pv.data(), 0.1, telem.data());
+
+    int jumps = 0;
+    long before = g_alloc_count.load();
+    for (int i = 0; i < 200; ++i) {
+        ssd_ensemble_step(e, pv.data(), 0.1, telem.data());
+        jumps += telem[0].did_jump;
+    }
+    long allocs = g_alloc_count.load() - before;
+
+    ssd_ensemble_destroy(e);
+
+    std::cout << "Steps: 200, member 0 jumps: " << jumps << ", allocations: " << allocs << std::endl;
+    if (allocs != 0) {
+        std::cout << "ERROR: ssd_ensemble_step allocated during steady-state stepping" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Step Allocation Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    SSDParams quiet{};
+    total_tests++;
+    if (run_alloc_test("Deterministic Steps", quiet, 0.5) == 0) passed_tests++;
+
+    // 跳躍が頻発する設定（RelaxTop・ソフトマックス経路を通す）
+    SSDParams jumpy{};
+    jumpy.h0 = 50.0;
+    jumpy.eps_noise = 0.05;
+    total_tests++;
+    if (run_alloc_test("Jump-Heavy Noisy Steps", jumpy, 2.0) == 0) passed_tests++;
+    total_tests++;
+    if (run_ensemble_alloc_test("Ensemble Steps (2 threads)", jumpy, 2.0) == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+﻿/*
+ * test_step_n.cpp
+ * ssd_step_n / ssd_step_n_interp と ssd_step 逐次呼び出しの一致検証
+ */
+
+#include "core/ssd_core.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+// ssd_step を逐次呼び出して ssd_step_n と同じ間引きで記録する
+static std::vector<SSDTelemetry> reference_run(SSDHandle* h, const std::vector<double>& p,
+                                               double dt, int stride) {
+    std::vector<SSDTelemetry> recs;
+    for (size_t t = 0; t < p.size(); ++t) {
+        SSDTelemetry tel;
+        ssd_step(h, p[t], dt, &tel);
+        if (tel.did_jump || (stride > 0 && (t + 1) % stride == 0)) recs.push_back(tel);
+    }
+    return recs;
+}
+
+// 同じ演算順序なのでビット一致（構造体末尾の詰め物は比較しない）
+static bool same_bits(double x, double y) { return std::memcmp(&x, &y, sizeof(double)) == 0; }
+
+static bool same_records(const std::vector<SSDTelemetry>& a, const SSDTelemetry* b, int32_t n) {
+    if ((int32_t)a.size() != n) return false;
+    for (int32_t i = 0; i < n; ++i) {
+        const SSDTelemetry& x = a[i];
+        const SSDTelemetry& y = b[i];
+        if (!same_bits(x.E, y.E) || !same_bits(x.Theta, y.Theta) || !same_bits(x.h, y.h) ||
+            !same_bits(x.T, y.T) || !same_bits(x.H, y.H) || !same_bits(x.J_norm, y.J_norm) ||
+            !same_bits(x.align_eff, y.align_eff) || !same_bits(x.kappa_mean, y.kappa_mean) ||
+            x.current != y.current || x.did_jump != y.did_jump || x.rewired_to != y.rewired_to) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int check_step_n(const char* name, bool sparse, const SSDParams& params, int stride) {
+    print_test_header(name);
+
+    const int N = 32;
+    const int steps = 500;
+    SSDHandle* ref = sparse ? ssd_create_sparse(N, &params, 77) : ssd_create(N, &params, 77);
+    SSDHandle* bulk = sparse ? ssd_create_sparse(N, &params, 77) : ssd_create(N, &params, 77);
+    if (!ref || !bulk) {
+        std::cout << "ERROR: Failed to create handles" << std::endl;
+        ssd_destroy(ref);
+        ssd_destroy(bulk);
+        return 1;
+    }
+
+    std::vector<double> p(steps);
+    for (int t = 0; t < steps; ++t) p[t] = (t / 50) % 2 ? 0.3 : 2.5 + std::sin(t * 0.1);
+
+    std::vector<SSDTelemetry> expected = reference_run(ref, p, 0.1, stride);
+
+    // 2回に分けて呼んでも同じ結果になること
+    std::vector<SSDTelemetry> out(steps);
+    int half = steps / 2;
+    int32_t n1 = ssd_step_n(bulk, p.data(), half, 0.1, out.data(), stride);
+    // 前半が stride で割り切れるので間引き位置も一致する
+    int32_t n2 = ssd_step_n(bulk, p.data() + half, steps - half, 0.1, out.data() + n1, stride);
+
+    bool ok = same_records(expected, out.data(), n1 + n2);
+
+    std::vector<double> row_r(N), row_b(N);
+    for (int r = 0; r < N && ok; ++r) {
+        ssd_get_kappa_row(ref, r, row_r.data(), N);
+        ssd_get_kappa_row(bulk, r, row_b.data(), N);
+        ok = std::memcmp(row_r.data(), row_b.data(), sizeof(double) * N) == 0;
+    }
+
+    ssd_destroy(ref);
+    ssd_destroy(bulk);
+
+    std::cout << "Stride: " << stride << ", records: " << (n1 + n2) << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: ssd_step_n differs from ssd_step loop" << std::endl;
+        return 1;
+    }
+    std::cout << "Records and final state match" << std::endl;
+    return 0;
+}
+
+int check_interp() {
+    print_test_header("Interpolated Schedule");
+
+    SSDParams params{};
+    params.h0 = 2.0;
+    const int N = 16;
+    const int steps = 301;
+    const double knots[4] = {0.0, 3.0, 1.0, 2.0};
+
+    SSDHandle* ref = ssd_create(N, &params, 5);
+    SSDHandle* bulk = ssd_create(N, &params, 5);
+    if (!ref || !bulk) {
+        std::cout << "ERROR: Failed to create handles" << std::endl;
+        ssd_destroy(ref);
+        ssd_destroy(bulk);
+        return 1;
+    }
+
+    // 節点はステップ 0, 100, 200, 300
+    std::vector<double> p(steps);
+    for (int t = 0; t < steps; ++t) {
+        int k = std::min(t / 100, 2);
+        double f = (t - k * 100) / 100.0;
+        p[t] = knots[k] + (knots[k + 1] - knots[k]) * f;
+    }
+
+    std::vector<SSDTelemetry> expected = reference_run(ref, p, 0.1, 10);
+    std::vector<SSDTelemetry> out(steps);
+    int32_t n = ssd_step_n_interp(bulk, knots, 4, steps, 0.1, out.data(), 10);
+
+    // 補間の丸め順序が異なり得るので値は許容誤差で比較
+    bool ok = (int32_t)expected.size() == n;
+    for (int32_t i = 0; i < n && ok; ++i) {
+        ok = expected[i].current == out[i].current && expected[i].did_jump == out[i].did_jump &&
+             std::abs(expected[i].E - out[i].E) <= 1e-9 &&
+             std::abs(expected[i].J_norm - out[i].J_norm) <= 1e-9;
+    }
+
+    ssd_destroy(ref);
+    ssd_destroy(bulk);
+
+    std::cout << "Knots: 4, steps: " << steps << ", records: " << n << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: interpolated schedule differs from reference" << std::endl;
+        return 1;
+    }
+    std::cout << "Interpolated schedule matches" << std::endl;
+    return 0;
+}
+
+int check_invalid() {
+    print_test_header("Invalid Arguments");
+
+    SSDHandle* h = ssd_create(8, nullptr, 1);
+    double p[2] = {1.0, 1.0};
+    SSDTelemetry out[2];
+    bool ok = ssd_step_n(nullptr, p, 2, 0.1, out, 1) == 0 &&
+              ssd_step_n(h, nullptr, 2, 0.1, out, 1) == 0 &&
+              ssd_step_n(h, p, 0, 0.1, out, 1) == 0 &&
+              ssd_step_n_interp(h, p, 0, 2, 0.1, out, 1) == 0 &&
+              ssd_step_n(h, p, 2, 0.1, nullptr, 1) == 0;  // 書き出し先なしでも進む
+    ssd_destroy(h);
+
+    std::cout << (ok ? "Invalid arguments rejected" : "ERROR: unexpected return value") << std::endl;
+    return ok ? 0 : 1;
+}
+
+int main() {
+    std::cout << "SSD Core - Multi-Step API Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    SSDParams jumpy{};
+    jumpy.G0 = 0.01;
+    jumpy.g = 0.02;
+    jumpy.h0 = 5.0;
+    jumpy.eps0 = 0.3;
+    jumpy.eps_noise = 0.02;
+
+    total_tests++;
+    if (check_step_n("Dense, stride 10", false, jumpy, 10) == 0) passed_tests++;
+    total_tests++;
+    if (check_step_n("Dense, jumps only", false, jumpy, 0) == 0) passed_tests++;
+    // 疎グラフは経路ノイズを受け付けない
+    SSDParams jumpy_quiet = jumpy;
+    jumpy_quiet.eps_noise = 0.0;
+    total_tests++;
+    if (check_step_n("Sparse, stride 25", true, jumpy_quiet, 25) == 0) passed_tests++;
+    total_tests++;
+    if (check_interp() == 0) passed_tests++;
+    total_tests++;
+    if (check_invalid() == 0) passed_tests++;
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+﻿/*
+ * test_storage_precision.cpp
+ * float / bf16 格納（ssd_create_ex）と double 版の精度比較
+ */
+
+#include "core/ssd_core.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+void print_test_header(const char* test_name) {
+    std::cout << "\n=== " << test_name << " ===" << std::endl;
+}
+
+static double rel_err(double a, double ref) {
+    return std::abs(a - ref) / std::max(1e-12, std::abs(ref));
+}
+
+static double pressure_wave(int t) { return 1.5 + std::sin(t * 0.05); }
+
+// 跳躍・ε探索なし（軌道の分岐なし）で kappa の連続的な誤差だけを比較する
+int compare_storage(const char* name, int32_t storage, double tol) {
+    print_test_header(name);
+
+    SSDParams params{};
+    params.h0 = 0.0;
+    params.eps0 = 0.0;
+    params.d1 = 0.0;
+    params.eps_noise = 0.02;
+
+    const int N = 64;
+    const int steps = 1000;
+    SSDCreateOptions opts;
+    opts.storage = storage;
+    SSDHandle* ref = ssd_create(N, &params, 31);
+    SSDHandle* low = ssd_create_ex(N, &params, 31, &opts);
+    if (!ref || !low) {
+        std::cout << "ERROR: Failed to create handles" << std::endl;
+        ssd_destroy(ref);
+        ssd_destroy(low);
+        return 1;
+    }
+
+    double max_kappa_mean = 0.0, max_J = 0.0, max_E = 0.0;
+    for (int t = 0; t < steps; ++t) {
+        SSDTelemetry tr, tl;
+        ssd_step(ref, pressure_wave(t), 0.1, &tr);
+        ssd_step(low, pressure_wave(t), 0.1, &tl);
+        max_kappa_mean = std::max(max_kappa_mean, rel_err(tl.kappa_mean, tr.kappa_mean));
+        max_J = std::max(max_J, rel_err(tl.J_norm, tr.J_norm));
+        max_E = std::max(max_E, std::abs(tl.E - tr.E));
+    }
+
+    // 行の読み出しは double で返り、要素ごとの誤差も格納精度相当
+    double max_edge = 0.0;
+    std::vector<double> row_r(N), row_l(N);
+    for (int r = 0; r < N; ++r) {
+        ssd_get_kappa_row(ref, r, row_r.data(), N);
+        ssd_get_kappa_row(low, r, row_l.data(), N);
+        for (int c = 0; c < N; ++c) {
+            max_edge = std::max(max_edge, std::abs(row_l[c] - row_r[c]) / std::max(1.0, row_r[c]));
+        }
+    }
+
+    ssd_destroy(ref);
+    ssd_destroy(low);
+
+    std::cout << "max rel err kappa_mean: " << max_kappa_mean << ", J_norm: " << max_J
+              << ", abs err E: " << max_E << ", edge: " << max_edge << std::endl;
+    if (max_kappa_mean > tol || max_J > tol || max_E > tol || max_edge > 10 * tol) {
+        std::cout << "ERROR: error exceeds tolerance " << tol << std::endl;
+        return 1;
+    }
+    std::cout << "Within tolerance " << tol << std::endl;
+    return 0;
+}
+
+// 跳躍・RelaxTop を含む設定でも各格納型が有限値で進むこと
+int smoke_jumpy(const char* name, int32_t storage) {
+    print_test_header(name);
+
+    SSDParams jumpy{};
+    jumpy.G0 = 0.01;
+    jumpy.g = 0.02;
+    jumpy.h0 = 5.0;
+    jumpy.eps0 = 0.3;
+
+    SSDCreateOptions opts;
+    opts.storage = storage;
+    SSDHandle* h = ssd_create_ex(40, &jumpy, 3, &opts);
+    if (!h) {
+        std::cout << "ERROR: Failed to create handle" << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    int jumps = 0;
+    SSDTelemetry t;
+    for (int i = 0; i < 500 && ok; ++i) {
+        ssd_step(h, (i / 40) % 2 ? 0.0 : 3.0, 0.1, &t);
+        jumps += t.did_jump;
+        ok = std::isfinite(t.kappa_mean) && std::isfinite(t.J_norm) && std::isfinite(t.E) &&
+             t.current >= 0 && t.current < 40;
+    }
+    ssd_destroy(h);
+
+    std::cout << "Steps: 500, jumps: " << jumps << ", kappa_mean: " << t.kappa_mean << std::endl;
+    if (!ok) {
+        std::cout << "ERROR: non-finite telemetry" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main() {
+    std::cout << "SSD Core - Storage Precision Test" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    total_tests++;
+    if (compare_storage("Float32 vs Double", SSD_STORAGE_F32, 1e-4) == 0) passed_tests++;
+    total_tests++;
+    if (compare_storage("BFloat16 vs Double", SSD_STORAGE_BF16, 2e-2) == 0) passed_tests++;
+    total_tests++;
+    if (smoke_jumpy("Float32 Jump-Heavy", SSD_STORAGE_F32) == 0) passed_tests++;
+    total_tests++;
+    if (smoke_jumpy("BFloat16 Jump-Heavy", SSD_STORAGE_BF16) == 0) passed_tests++;
+
+    print_test_header("Invalid Storage");
+    total_tests++;
+    SSDCreateOptions bad;
+    bad.storage = 7;
+    SSDHandle* h = ssd_create_ex(8, nullptr, 1, &bad);
+    if (!h) {
+        std::cout << "Unknown storage rejected" << std::endl;
+        passed_tests++;
+    } else {
+        std::cout << "ERROR: unknown storage accepted" << std::endl;
+        ssd_destroy(h);
+    }
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Test Results: " << passed_tests << "/" << total_tests << " passed" << std::endl;
+
+    return passed_tests == total_tests ? 0 : 1;
+}